@@ -0,0 +1,132 @@
+/*
+ * \brief  Shared worker threads for checkpointing
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_CHECKPOINT_POOL_H_
+#define _RTCR_CHECKPOINT_POOL_H_
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/thread.h>
+#include <base/lock.h>
+#include <base/semaphore.h>
+#include <util/fifo.h>
+#include <util/reconstructible.h>
+#include <util/xml_node.h>
+
+namespace Rtcr {
+	class Checkpoint_pool;
+}
+
+
+/**
+ * Worker threads executing the checkpoints of all checkpointables
+ *
+ * Each configured core runs one worker with its own queue of tasks. A task
+ * is submitted to the queue of its preferred worker. A worker without tasks
+ * steals tasks from the queues of the other workers. Therefore, the number of
+ * threads is independent of the number of childs.
+ *
+ * Example configuration:
+ *
+ * ```XML
+ * <checkpoint_pool>
+ *   <core xpos="0" ypos="0"/>
+ *   <core xpos="1" ypos="0"/>
+ * </checkpoint_pool>
+ * ```
+ */
+class Rtcr::Checkpoint_pool
+{
+public:
+
+	struct Task : Genode::Fifo<Task>::Element
+	{
+		virtual void run() = 0;
+		virtual ~Task() { }
+	};
+
+	enum { MAX_WORKERS = 32 };
+
+private:
+
+	struct Worker : Genode::Thread
+	{
+		Checkpoint_pool &_pool;
+		unsigned const _index;
+		Genode::Affinity::Location const _location;
+
+		Genode::Lock _lock;
+		Genode::Fifo<Task> _tasks;
+
+		Worker(Genode::Env &env, Checkpoint_pool &pool, unsigned index,
+		       Genode::Affinity::Location location);
+
+		/**
+		 * \return next task of the queue or nullptr
+		 */
+		Task *take();
+
+		void entry() override;
+	};
+
+	Genode::Constructible<Worker> _workers[MAX_WORKERS];
+	unsigned _count = 0;
+
+	/**
+	 * Counts the queued tasks, idle workers block on it. Withdrawn tasks
+	 * leave their count behind, therefore a worker may find no task.
+	 */
+	Genode::Semaphore _pending;
+
+	/**
+	 * Worker for the next task without a preferred worker
+	 */
+	unsigned _next = 0;
+	Genode::Lock _next_lock;
+
+	/* not copyable */
+	Checkpoint_pool(Checkpoint_pool const &);
+	Checkpoint_pool &operator = (Checkpoint_pool const &);
+
+public:
+
+	/**
+	 * \param config  `checkpoint_pool` node of the configuration
+	 */
+	Checkpoint_pool(Genode::Env &env, Genode::Xml_node config);
+
+	unsigned workers() const { return _count; }
+
+	/**
+	 * \return index of the worker running on `location` or `workers()`, if
+	 *         no worker runs there
+	 */
+	unsigned worker(Genode::Affinity::Location location) const;
+
+	/**
+	 * Queue a task
+	 *
+	 * \param preferred  index of the worker, which should execute the task.
+	 *                   If out of range, the tasks are distributed round
+	 *                   robin.
+	 * \return           index of the queue holding the task
+	 */
+	unsigned submit(Task &task, unsigned preferred);
+
+	/**
+	 * Remove a task, which was not taken by a worker yet
+	 *
+	 * A thread waiting for a task executes the task itself, if it is still
+	 * queued. Thereby, a task executed by a worker may wait for other tasks
+	 * without blocking the pool.
+	 *
+	 * \param queue  index returned by `submit()`
+	 * \return       true, if the task was removed
+	 */
+	bool withdraw(Task &task, unsigned queue);
+};
+
+#endif /* _RTCR_CHECKPOINT_POOL_H_ */
@@ -0,0 +1,180 @@
+/*
+ * \brief  Periodic and adaptive triggering of checkpoints
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_CHECKPOINT_SCHEDULER_H_
+#define _RTCR_CHECKPOINT_SCHEDULER_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <base/entrypoint.h>
+#include <base/attached_rom_dataspace.h>
+#include <base/signal.h>
+#include <util/list.h>
+#include <util/xml_node.h>
+#include <timer_session/connection.h>
+
+/* Rtcr includes */
+#include <rtcr/init_module.h>
+
+namespace Rtcr {
+	class Checkpoint_scheduler;
+}
+
+
+/**
+ * Checkpoints the childs of a module periodically
+ *
+ * Each child is checkpointed after its interval elapsed. All childs whose
+ * interval elapsed are checkpointed together. The timeouts are handled by an
+ * entrypoint of the scheduler, hence the scheduler works while the creator
+ * blocks.
+ *
+ * In the adaptive mode, the interval of a child is recomputed after each of
+ * its checkpoints. The interval is shortened, so that at most `max_loss_pages`
+ * pages are changed between two checkpoints at the observed dirty rate, and
+ * prolonged, so that checkpointing takes at most `overhead` percent of the
+ * time. The interval is kept between `min_period_us` and `period_us`, unless
+ * the overhead bound requires a longer one.
+ *
+ * Example configuration:
+ *
+ * ```XML
+ * <scheduler period_us="1000000" adaptive="true" min_period_us="10000"
+ *            max_loss_pages="1024" overhead="10">
+ *   <child name="sheep_counter" period_us="500000"/>
+ * </scheduler>
+ * ```
+ */
+class Rtcr::Checkpoint_scheduler
+{
+private:
+
+	typedef Genode::String<100> Child_name;
+
+	/**
+	 * Schedule of a single child
+	 */
+	struct Schedule : Genode::List<Schedule>::Element
+	{
+		Child_name const name;
+
+		/* configured maximum interval and current interval */
+		Genode::uint64_t const period_us;
+		Genode::uint64_t interval_us;
+
+		/* time of the last and of the next checkpoint */
+		Genode::uint64_t last_us;
+		Genode::uint64_t next_us;
+
+		/* moving average of the changed pages per second */
+		Genode::uint64_t dirty_rate = 0;
+
+		Schedule(Child_name const &name, Genode::uint64_t period_us,
+		         Genode::uint64_t now_us)
+			:
+			name(name), period_us(period_us), interval_us(period_us),
+			last_us(now_us), next_us(now_us + period_us) { }
+	};
+
+	Genode::Allocator &_alloc;
+	Init_module &_module;
+
+	/**
+	 * Rom dataspace holding configuration
+	 */
+	Genode::Attached_rom_dataspace _config;
+
+	/**
+	 * \return attribute `attr` of the `scheduler` node
+	 */
+	template <typename T>
+	T _read(char const *attr, T default_value)
+	{
+		try {
+			return _config.xml().sub_node("scheduler").attribute_value(attr, default_value);
+		} catch(...) { }
+		return default_value;
+	}
+
+	Genode::uint64_t const _period_us;
+	Genode::uint64_t const _min_period_us;
+
+	/**
+	 * Shortest configured period, after which new childs are looked for
+	 */
+	Genode::uint64_t const _poll_us;
+	inline Genode::uint64_t _read_poll_us();
+	bool const _adaptive;
+	Genode::size_t const _max_loss_pages;
+	unsigned const _overhead;
+
+	Genode::Lock _lock;
+	Genode::List<Schedule> _schedules;
+
+	Genode::Entrypoint _ep;
+	Timer::Connection _timer;
+	Genode::Signal_handler<Checkpoint_scheduler> _timeout_handler;
+
+	/**
+	 * Childs whose interval elapsed
+	 */
+	struct Due : Init_module::Child_selection
+	{
+		Checkpoint_scheduler &_scheduler;
+		Genode::uint64_t const _now_us;
+
+		Due(Checkpoint_scheduler &scheduler, Genode::uint64_t now_us)
+			: _scheduler(scheduler), _now_us(now_us) { }
+
+		bool selected(Child_info const &child) const override;
+	};
+
+	/**
+	 * \return schedule of `child`, which is created on the first call
+	 *
+	 * \param due  a created schedule is due immediately, because the child
+	 *             appeared since the last timeout. Otherwise, its first
+	 *             checkpoint follows after its period.
+	 */
+	Schedule &_schedule(Child_info const &child, bool due);
+
+	/**
+	 * \return period of the child named `name` in microseconds
+	 */
+	Genode::uint64_t _child_period_us(Child_name const &name);
+
+	/**
+	 * Recompute the interval of a child after its checkpoint
+	 */
+	void _adapt(Schedule &schedule, Child_info &child,
+	            Genode::uint64_t now_us, Genode::uint64_t cost_us);
+
+	void _handle_timeout();
+
+	/**
+	 * Create the schedules of new childs and program the timer for the next
+	 * due child
+	 */
+	void _arm(Genode::uint64_t now_us);
+
+	/* not copyable */
+	Checkpoint_scheduler(Checkpoint_scheduler const &);
+	Checkpoint_scheduler &operator = (Checkpoint_scheduler const &);
+
+public:
+
+	Checkpoint_scheduler(Genode::Env &env, Genode::Allocator &alloc,
+	                     Init_module &module);
+	~Checkpoint_scheduler();
+
+	/**
+	 * \return current interval of the child named `name` in microseconds
+	 *         or 0, if the child was not scheduled yet
+	 */
+	Genode::uint64_t interval_us(char const *name);
+};
+
+#endif /* _RTCR_CHECKPOINT_SCHEDULER_H_ */
@@ -16,9 +16,13 @@
 #include <util/xml_node.h>
 #include <timer_session/connection.h>
 #include <base/attached_rom_dataspace.h>
+#include <base/semaphore.h>
 
 /* Rtcr includes */
 #include <util/event.h>
+#include <util/latency_histogram.h>
+#include <rtcr/checkpoint_pool.h>
+#include <rtcr/placement.h>
 
 namespace Rtcr {
 	class Checkpointable;
@@ -29,16 +33,47 @@ using namespace Rtcr;
 
 /**
  * This class provides an interface for checkpointing in a seperate thread.
+ *
+ * If the configuration contains a `checkpoint_pool` node, the checkpoint is
+ * executed as a task of the shared `Checkpoint_pool` instead of a dedicated
+ * thread. The affinity of the checkpointable selects the preferred worker.
+ *
+ * If the configuration contains a `placement` node with mode `auto`, the
+ * checkpointables without `checkpointable` node are placed by `Placement`.
  */
-class Rtcr::Checkpointable : private Genode::Thread
+class Rtcr::Checkpointable : private Checkpoint_pool::Task
 {
 private:
 
+	/**
+	 * Thread executing the checkpoints, if no pool is configured
+	 */
+	struct Dedicated_thread : Genode::Thread
+	{
+		Checkpointable &_owner;
+
+		Dedicated_thread(Genode::Env &env, const char *name,
+		                 Genode::Affinity::Location location,
+		                 Checkpointable &owner)
+			:
+			Genode::Thread(env, name, 64*1024, location,
+			               Genode::Thread::Weight(), env.cpu()),
+			_owner(owner) { }
+
+		void entry() override { _owner._serve(); }
+	};
+
+	/**
+	 * Name of the thread and of the phase in the trace
+	 */
+	Genode::String<32> const _name;
+
 	/**
 	 * Timer connection for measuring time of a checkpoint
 	 */
 	Timer::Connection _timer;
 	unsigned long long _checkpoint_time;
+	Latency_histogram _latency;
 
 
 	/**
@@ -47,6 +82,14 @@ private:
 	Genode::Attached_rom_dataspace _config;
   
 	Genode::Affinity::Location _affinity;	
+
+	/**
+	 * Shared pool and the preferred worker, or dedicated thread
+	 */
+	Checkpoint_pool *_pool;
+	unsigned _worker = 0;
+	unsigned _queue = 0;
+	Genode::Constructible<Dedicated_thread> _thread;
 	/**
 	 * Indicator which pause this thread until a new job
 	 * (checkpoint,restore) are triggered.
@@ -71,15 +114,30 @@ private:
 	 */
 	Event _checkpoint_finished;
 
+	/**
+	 * Semaphore upped after each checkpoint, if set
+	 */
+	Genode::Semaphore *_finished_signal = nullptr;
+
 	/**
 	 * If `_running` is false, no further jobs are processed and the
 	 * `entry()` method will be left. The thread stops.
 	 */
 	bool _running;
 	/**
-	 * Entrypoint of the started thread.
+	 * Entrypoint of the dedicated thread.
+	 */
+	void _serve();
+
+	/**
+	 * Execute a checkpoint job
 	 */
-	void entry();
+	void _execute();
+
+	/**
+	 * Task interface, called by a worker of the pool
+	 */
+	void run() override { _execute(); }
 
 	/**
 	 * event for signaling that a checkpoint is possible
@@ -95,7 +153,19 @@ private:
 	 * <checkpointable name="cpu_session" xpos="1" ypos="0" />
 	 * ```
 	 */
-	inline Genode::Affinity::Location _read_affinity(const char* node_name);
+	inline Genode::Affinity::Location _read_affinity(Genode::Env &env, const char* node_name);
+
+	/**
+	 * \return placement shared by all checkpointables or nullptr, if the
+	 *         configuration contains no `placement` node with mode `auto`
+	 */
+	inline Placement *_read_placement(Genode::Env &env);
+
+	/**
+	 * \return pool shared by all checkpointables or nullptr, if the
+	 *         configuration contains no `checkpoint_pool` node
+	 */
+	inline Checkpoint_pool *_read_pool(Genode::Env &env);
 
 protected:
 	void ready();
@@ -131,6 +201,14 @@ public:
 	 * If no job is in progress, this method will directly return.
 	 */
 	void join_checkpoint();
+
+	/**
+	 * Execute the started checkpoint by the calling thread, if it is still
+	 * queued in the pool
+	 *
+	 * \return true, if the checkpoint was executed
+	 */
+	bool execute_queued();
 		
 	/**
 	 * Starts a checkpoint
@@ -142,6 +220,16 @@ public:
 	 */
 	void stop();
 
+	/**
+	 * Up `signal` after each finished checkpoint, nullptr disables it
+	 */
+	void finished_signal(Genode::Semaphore *signal) { _finished_signal = signal; }
+
+	/**
+	 * \return true, if the last started checkpoint is finished
+	 */
+	bool checkpoint_finished() { return _checkpoint_finished.is_set(); }
+
 	/** 
 	 * wait until this checkpointable is ready for a checkpoint 
 	 */
@@ -153,6 +241,16 @@ public:
 	bool is_ready() { return _ready_event.is_set(); }
 
 	unsigned long long checkpoint_time() { return _checkpoint_time; }
+
+	/**
+	 * \return durations of all checkpoints of this checkpointable
+	 */
+	Latency_histogram const &latency() const { return _latency; }
+
+	/**
+	 * \return time of the timer of this checkpointable in microseconds
+	 */
+	unsigned long long elapsed_us() { return _timer.elapsed_us(); }
 };
 
 
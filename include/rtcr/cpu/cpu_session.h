@@ -25,6 +25,7 @@
 #include <rtcr/pd/pd_session.h>
 #include <rtcr/checkpointable.h>
 #include <rtcr/child_info.h>
+#include <util/badge_list.h>
 
 namespace Rtcr {
 	class Cpu_session;
@@ -51,7 +52,7 @@ protected:
 	Genode::Lock _cpu_threads_lock;
 	Genode::Lock _destroyed_cpu_threads_lock;
 	
-	Genode::List<Cpu_thread_info> _cpu_threads;
+	Badge_list<Cpu_thread_info> _cpu_threads;
 	Genode::Fifo<Cpu_thread_info> _destroyed_cpu_threads;
 
 	/**
@@ -118,6 +119,87 @@ protected:
 	Genode::Capability<Cpu_session::Native_cpu> _setup_native_cpu();
 	void _cleanup_native_cpu();
 
+	/**
+	 * Start of the current pause and duration of the last pause
+	 */
+	unsigned long long _paused_at = 0;
+	unsigned long long _pause_time = 0;
+
+	/**
+	 * Time between the first and the last thread being paused by the last
+	 * pause
+	 */
+	unsigned long long _pause_skew = 0;
+
+	/**
+	 * Time span in which the threads of a share were paused or resumed
+	 */
+	struct Pause_span
+	{
+		unsigned long long first = ~0ULL;
+		unsigned long long last = 0;
+
+		void add(unsigned long long time)
+		{
+			first = Genode::min(first, time);
+			last = Genode::max(last, time);
+		}
+
+		void add(Pause_span const &other)
+		{
+			first = Genode::min(first, other.first);
+			last = Genode::max(last, other.last);
+		}
+
+		unsigned long long length() const { return last > first ? last - first : 0; }
+	};
+
+	/**
+	 * Worker which pauses and resumes a share of the threads in parallel to
+	 * the caller of `pause` and `resume`
+	 *
+	 * The threads are split round robin into one share for the caller and
+	 * one for each worker. The affinity of worker `i` is configured by the
+	 * checkpointable node named `cpu_pause_worker_<i>`.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint pause_workers="3"/>
+	 * ```
+	 */
+	struct Pause_worker : Rtcr::Checkpointable,
+	                      Genode::List<Pause_worker>::Element
+	{
+		using Genode::List<Pause_worker>::Element::next;
+
+		Cpu_session &_cpu;
+		unsigned const _share;
+		Pause_span span { };
+
+		Pause_worker(Genode::Env &env, Cpu_session &cpu, unsigned share,
+		             const char *name)
+			:
+			Checkpointable(env, name),
+			_cpu(cpu), _share(share) { }
+
+		void checkpoint() override;
+	};
+	Genode::List<Pause_worker> _pause_workers;
+	unsigned _num_pause_workers = 0;
+	bool _resuming = false;
+	inline unsigned _read_pause_workers();
+
+	/**
+	 * Pause or resume the threads of a share
+	 */
+	Pause_span _pause_threads(unsigned share, bool resume);
+
+	/**
+	 * Pause or resume all threads by the caller and all pause workers
+	 */
+	Pause_span _pause_all_threads(bool resume);
+
 
 	
 public:
@@ -143,6 +225,17 @@ public:
 	 */	
 	void resume();
 
+	/**
+	 * \return duration of the last pause in microseconds
+	 */
+	unsigned long long pause_time() const { return _pause_time; }
+
+	/**
+	 * \return time between the first and the last thread being paused by
+	 *         the last pause in microseconds
+	 */
+	unsigned long long pause_skew() const { return _pause_skew; }
+
 
 	void checkpoint() override;
 
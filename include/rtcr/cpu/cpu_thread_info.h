@@ -41,10 +41,10 @@ public:
 
 	
 	Cpu_thread_info *find_by_badge(Genode::uint16_t badge) {
-		if(badge == i_badge)
-			return this;
-		Cpu_thread_info *obj = next();
-		return obj ? obj->find_by_badge(badge) : 0;
+		Cpu_thread_info *info = this;
+		while(info && badge != info->i_badge)
+			info = info->next();
+		return info;
 	}
 
 	
@@ -47,6 +47,11 @@ struct Rtcr::Normal_info
 	Normal_info(Genode::uint16_t badge) : i_badge(badge) {}
 
 	Normal_info() {}
+
+	/**
+	 * \return key of the info in a `Badge_list`
+	 */
+	Genode::uint16_t badge() const { return i_badge; }
 	
 	void print(Genode::Output &output) const {
 		Genode::print(output,
@@ -14,6 +14,7 @@
 #include <base/attached_rom_dataspace.h>
 #include <base/registry.h>
 #include <os/reporter.h>
+#include <timer_session/connection.h>
 
 /* Rtcr includes */
 #include <rtcr/cpu/cpu_session.h>
@@ -22,6 +23,7 @@
 #include <rtcr/log/log_session.h>
 #include <rtcr/timer/timer_session.h>
 #include <rtcr/rom/rom_session.h>
+#include <rtcr/tracer.h>
 #include <rtcr/cap/capability_mapping.h>
 #include <rtcr/child_info.h>
 
@@ -41,7 +43,103 @@ using namespace Rtcr;
  */
 class Rtcr::Init_module
 {
+public:
+
+	/**
+	 * Stage of the checkpoint of a child
+	 *
+	 * A stage starts as soon as all stages it depends on are finished. In
+	 * the parallel mode, all stages whose dependencies are finished run
+	 * concurrently. Otherwise, the stages run one after another in the order
+	 * they were added. Dependencies on stages which do not exist are
+	 * ignored.
+	 */
+	struct Stage : Genode::List<Stage>::Element
+	{
+		typedef Genode::String<32> Name;
+		enum { MAX_DEPENDENCIES = 8 };
+
+		Name const name;
+		Name dependencies[MAX_DEPENDENCIES];
+		unsigned num_dependencies = 0;
+
+		Stage(Name const &name) : name(name) { }
+		virtual ~Stage() { }
+
+		/**
+		 * Start this stage only after stage `name` is finished
+		 */
+		void depends_on(Name const &name)
+		{
+			if(num_dependencies == MAX_DEPENDENCIES) {
+				Genode::error("Stage ", this->name, " has too many dependencies");
+				return;
+			}
+			dependencies[num_dependencies++] = name;
+		}
+
+		/**
+		 * \return checkpointable executing this stage for `child` or
+		 *         nullptr, if the stage has nothing to do for the child
+		 */
+		virtual Checkpointable *checkpointable(Child_info &child) = 0;
+	};
+
+	/**
+	 * Selection of the childs checkpointed by `checkpoint`
+	 */
+	struct Child_selection
+	{
+		virtual ~Child_selection() { }
+		virtual bool selected(Child_info const &child) const = 0;
+	};
+
 protected:
+
+	/**
+	 * Stage checkpointing one of the sessions of a child
+	 */
+	struct Session_stage : Stage
+	{
+		enum Session { PD, RAM, CPU, RM, ROM, LOG, TIMER, CAPABILITY_MAPPING };
+		Session const session;
+
+		Session_stage(Name const &name, Session session)
+			: Stage(name), session(session) { }
+
+		Checkpointable *checkpointable(Child_info &child) override;
+	};
+
+	Session_stage _pd_stage    { "pd_session",     Session_stage::PD    };
+	Session_stage _ram_stage   { "ram_dataspaces", Session_stage::RAM   };
+	Session_stage _cpu_stage   { "cpu_session",    Session_stage::CPU   };
+	Session_stage _rm_stage    { "rm_session",     Session_stage::RM    };
+	Session_stage _rom_stage   { "rom_session",    Session_stage::ROM   };
+	Session_stage _log_stage   { "log_session",    Session_stage::LOG   };
+	Session_stage _timer_stage { "timer_session",  Session_stage::TIMER };
+	Session_stage _capability_mapping_stage { "capability_mapping",
+	                                          Session_stage::CAPABILITY_MAPPING };
+
+	/**
+	 * Stages of the checkpoint of a child in the order they were added
+	 */
+	enum { MAX_STAGES = 32 };
+	Genode::List<Stage> _stages;
+	Stage *_last_stage = nullptr;
+	unsigned _num_stages = 0;
+
+	/**
+	 * Append a stage, modules add their own stages in their constructor
+	 *
+	 * At most `MAX_STAGES` stages are accepted.
+	 */
+	void add_stage(Stage &stage);
+
+	/**
+	 * \return stage named `name` or nullptr
+	 */
+	Stage *stage(Stage::Name const &name);
+
 	/**
 	 * Entrypoint for managing child's resource-sessions (PD, CPU, RAM)
 	 */
@@ -62,7 +160,166 @@ protected:
 	bool _parallel;
 	inline bool read_parallel();
 
+	/**
+	 * Pre-copy rounds before the child is paused
+	 *
+	 * Each round copies the pages of the Ram dataspaces written since the
+	 * previous round while the child keeps running. The rounds stop early if
+	 * at most `_precopy_threshold` pages were copied by a round. Afterwards,
+	 * the childs are paused and checkpointed, which copies only the remaining
+	 * dirty pages. Requires the incremental copy mode.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint copy="incremental" precopy_rounds="3" precopy_threshold="64"/>
+	 * ```
+	 */
+	unsigned _precopy_rounds;
+	Genode::size_t _precopy_threshold;
+	inline unsigned read_precopy_rounds();
+	inline Genode::size_t read_precopy_threshold();
+
+	/**
+	 * Timer connection for measuring the time of a checkpoint
+	 */
+	Timer::Connection _timer;
+
+	/**
+	 * Duration of the last checkpoint including all pre-copy rounds, and
+	 * duration of checkpointing the childs without pre-copy rounds, i.e. the
+	 * time the childs are paused.
+	 */
+	unsigned long long _checkpoint_time = 0;
+	unsigned long long _pause_time = 0;
+
+	/**
+	 * Timeline of the checkpoint phases, published after each checkpoint
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <trace entries="4096"/>
+	 * ```
+	 */
+	Genode::Constructible<Tracer> _tracer;
+	inline Genode::size_t read_trace_entries();
+
+	/**
+	 * Durations of all checkpoints and pauses
+	 */
+	Latency_histogram _checkpoint_latency;
+	Latency_histogram _pause_latency;
+	unsigned _precopy_rounds_done = 0;
+
+	/**
+	 * Maximum number of childs which are checkpointed at the same time
+	 *
+	 * If greater than one, the childs are checkpointed by this number of
+	 * `Child_checkpointer` threads. Instead of pausing all childs for the
+	 * whole checkpoint, each child is paused, checkpointed and resumed on
+	 * its own.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint concurrent_childs="4"/>
+	 * ```
+	 */
+	unsigned _concurrent_childs;
+	inline unsigned read_concurrent_childs();
+
+	/**
+	 * Checkpointable which checkpoints childs until no child is left
+	 *
+	 * The affinity of checkpointer `i` is configured by the checkpointable
+	 * node named `child_checkpointer_<i>`.
+	 */
+	struct Child_checkpointer : Rtcr::Checkpointable,
+	                            Genode::List<Child_checkpointer>::Element
+	{
+		using Genode::List<Child_checkpointer>::Element::next;
+
+		Init_module &_module;
+
+		Child_checkpointer(Genode::Env &env, Init_module &module, const char *name)
+			:
+			Checkpointable(env, name),
+			_module(module) { }
+
+		void checkpoint() override;
+	};
+	Genode::List<Child_checkpointer> _child_checkpointers;
+
+	/**
+	 * Next child to be taken by a `Child_checkpointer` and whether it has
+	 * to be paused during its checkpoint
+	 */
+	Genode::Lock _next_child_lock;
+	Child_info *_next_child = nullptr;
+	bool _pause_each = false;
+
+	/**
+	 * \return next child to checkpoint or nullptr, if all childs are taken
+	 */
+	Child_info *take_next_child();
+
+	/**
+	 * Checkpoint all childs by the `Child_checkpointer` threads
+	 */
+	void checkpoint_concurrently(bool pause);
+
+	/**
+	 * Checkpoint a single child
+	 *
+	 * \param pause       pause the child until its state and, in the
+	 *                    double-buffered mode, its memory is captured
+	 * \param concurrent  the child is checkpointed by a `Child_checkpointer`,
+	 *                    which also starts the copy into the back buffers
+	 */
+	void checkpoint_child(Child_info &child, bool pause, bool concurrent);
+
 	void checkpoint(Child_info *child);
+
+	/**
+	 * Childs of the current checkpoint
+	 */
+	Child_selection const *_selection = nullptr;
+
+	struct All_childs : Child_selection
+	{
+		bool selected(Child_info const &) const override { return true; }
+	} const _all_childs { };
+	bool selected(Child_info const &child) const {
+		return !_selection || _selection->selected(child); }
+
+	/**
+	 * Execute pre-copy rounds for all childs
+	 *
+	 * \return number of executed rounds
+	 */
+	unsigned precopy();
+
+	/**
+	 * \return true, if the memory of a child is copied in the
+	 *         copy-on-write mode
+	 */
+	bool snapshot_mode();
+
+	/**
+	 * \return true, if the memory of a child is copied into double buffers
+	 */
+	bool double_buffered_mode();
+
+	/**
+	 * Held while the checkpointed state of the childs is updated
+	 *
+	 * In the double-buffered mode, the memory of the next checkpoint is
+	 * copied without holding this lock. All other checkpointed state exists
+	 * only once and is updated while holding it.
+	 */
+	Genode::Lock _generation_lock;
+
 	void report();
 	
 public:
@@ -78,9 +335,64 @@ public:
 		return _services;
 	}
 
+	/**
+	 * Checkpoint all childs
+	 */
 	void checkpoint();
-	void pause();
-	void resume();
+
+	/**
+	 * Checkpoint the childs of `selection`
+	 *
+	 * The checkpointed state of all other childs is kept.
+	 */
+	void checkpoint(Child_selection const &selection);
+
+	/**
+	 * \return duration of the last checkpoint in microseconds
+	 */
+	unsigned long long checkpoint_time() const { return _checkpoint_time; }
+
+	/**
+	 * \return time the childs were paused by the last checkpoint in
+	 *         microseconds
+	 */
+	unsigned long long pause_time() const { return _pause_time; }
+
+	/**
+	 * \return true, if the last checkpoint copied all Ram dataspaces
+	 *
+	 * If a time budget is configured, a checkpoint may copy only a part of
+	 * the Ram dataspaces. The following checkpoints continue copying until
+	 * this method returns true.
+	 */
+	bool checkpoint_complete();
+
+	/**
+	 * Call `fn` with the list of childs of the last complete checkpoint
+	 *
+	 * A concurrent checkpoint does not modify the checkpointed state until
+	 * `fn` returns.
+	 */
+	template<typename FN>
+	void with_checkpoint(FN const &fn)
+	{
+		Genode::Lock::Guard guard(_generation_lock);
+		fn(_childs);
+	}
+
+	/**
+	 * Pause and resume all threads of the childs of `selection`
+	 *
+	 * The childs which are not selected keep running.
+	 */
+	void pause(Child_selection const &selection);
+	void resume(Child_selection const &selection);
+
+	/**
+	 * Pause and resume all childs
+	 */
+	void pause() { pause(_all_childs); }
+	void resume() { resume(_all_childs); }
 
 	
 	void report_enabled(bool enabled);
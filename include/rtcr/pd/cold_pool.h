@@ -0,0 +1,118 @@
+/*
+ * \brief  Pool of pre-allocated cold dataspaces
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_COLD_POOL_H_
+#define _RTCR_COLD_POOL_H_
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/allocator.h>
+#include <base/thread.h>
+#include <base/lock.h>
+#include <util/list.h>
+
+/* Rtcr includes */
+#include <rtcr/pd/ram_dataspace.h>
+#include <util/event.h>
+
+namespace Rtcr {
+	class Cold_pool;
+}
+
+
+/**
+ * Pre-allocated and attached cold dataspaces in size classes
+ *
+ * Each size class is a power of two between 4 KiB and 1 MiB. A dataspace is
+ * paired with a cold dataspace of the smallest class which fits. A background
+ * thread refills each class to a fixed number of cold dataspaces. Therefore,
+ * neither the allocation nor the attachment of a cold dataspace causes an RPC
+ * during a checkpoint.
+ */
+class Rtcr::Cold_pool : private Genode::Thread
+{
+public:
+
+	enum {
+		MIN_SIZE_LOG2 = 12,
+		MAX_SIZE_LOG2 = 20,
+		NUM_CLASSES   = MAX_SIZE_LOG2 - MIN_SIZE_LOG2 + 1
+	};
+
+private:
+
+	struct Buffer : Genode::List<Buffer>::Element
+	{
+		Genode::Ram_dataspace_capability const cap;
+		void * const addr;
+
+		Buffer(Genode::Ram_dataspace_capability cap, void *addr)
+			: cap(cap), addr(addr) { }
+	};
+
+	Genode::Env       &_env;
+	Genode::Allocator &_alloc;
+
+	/**
+	 * Number of cold dataspaces kept in each size class
+	 */
+	unsigned const _count;
+
+	Genode::Lock _lock;
+	Genode::List<Buffer> _buffers[NUM_CLASSES];
+	unsigned _available[NUM_CLASSES];
+
+	/**
+	 * Set, if a size class needs to be refilled
+	 */
+	Event _refill_event;
+	bool _running;
+
+	/**
+	 * \return size class for `size` or -1, if `size` is not pooled
+	 */
+	static int _size_class(Genode::size_t size);
+
+	static Genode::size_t _class_size(int size_class) {
+		return 1UL << (size_class + MIN_SIZE_LOG2); }
+
+	void _refill();
+
+	void entry() override;
+
+public:
+
+	/**
+	 * \param count  number of cold dataspaces kept in each size class
+	 */
+	Cold_pool(Genode::Env &env, Genode::Allocator &alloc, unsigned count);
+
+	~Cold_pool();
+
+	/**
+	 * Pair `ds` with a cold dataspace of the pool
+	 *
+	 * On success, `ds.i_dst_cap`, `ds.dst_cap`, `ds.dst`, and `ds.cold_size`
+	 * are set.
+	 *
+	 * \return false, if no cold dataspace of a fitting size is available
+	 */
+	bool take(Ram_dataspace &ds);
+
+	/**
+	 * Return the cold dataspace of `ds` to the pool
+	 *
+	 * Only cold dataspaces whose size `ds.cold_size` matches a size class
+	 * exactly are accepted, which includes all cold dataspaces taken from
+	 * the pool. The cold dataspace stays attached.
+	 *
+	 * \return false, if the cold dataspace was not accepted
+	 */
+	bool put(Ram_dataspace &ds);
+};
+
+
+#endif /* _RTCR_COLD_POOL_H_ */
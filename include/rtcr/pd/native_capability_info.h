@@ -42,10 +42,10 @@ public:
 	}
 
 	Native_capability_info *find_by_native_badge(Genode::uint16_t badge) {
-		if(badge == i_badge)
-			return this;
-		Native_capability_info *info = next();
-		return info ? info->find_by_native_badge(badge) : 0;
+		Native_capability_info *info = this;
+		while(info && badge != info->i_badge)
+			info = info->next();
+		return info;
 	}
 };
 
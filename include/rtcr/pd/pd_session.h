@@ -27,13 +27,17 @@
 /* Rtcr includes */
 #include <rtcr/checkpointable.h>
 #include <rtcr/rm/region_map.h>
+#include <rtcr/rm/write_tracker.h>
+#include <rtcr/pd/cold_pool.h>
 #include <rtcr/pd/native_capability.h>
 #include <rtcr/pd/signal_context.h>
+#include <util/badge_list.h>
 #include <rtcr/pd/signal_source.h>
 #include <rtcr/pd/pd_session_info.h>
 #include <rtcr/pd/ram_dataspace.h>
 #include <rtcr/pd/ram_dataspace_info.h>
 #include <rtcr/child_info.h>
+#include <util/lz4.h>
 
 namespace Rtcr {
 	class Pd_session;
@@ -69,8 +73,32 @@ public:
 			_pd(pd) {};
 
 		void checkpoint() override;
+		void post_checkpoint() override;
 	} ram_checkpointable;
 
+
+	/**
+	 * Worker which copies chunks of large Ram dataspaces in parallel to
+	 * `ram_checkpointable`
+	 *
+	 * The affinity of worker `i` is configured by the checkpointable node
+	 * named `ram_copy_worker_<i>`.
+	 */
+	struct Copy_worker : Rtcr::Checkpointable,
+	                     Genode::List<Copy_worker>::Element
+	{
+		using Genode::List<Copy_worker>::Element::next;
+
+		Pd_session *_pd;
+
+		Copy_worker(Genode::Env &env, Pd_session *pd, const char *name)
+			:
+			Checkpointable(env, name),
+			_pd(pd) {};
+
+		void checkpoint() override;
+	};
+
 protected:
 	
 	const char* _upgrade_args;
@@ -80,7 +108,7 @@ protected:
 	 * Signal_source_capabilities
 	 */
 	Genode::Lock _signal_sources_lock;
-	Genode::List<Signal_source_info> _signal_sources;
+	Badge_list<Signal_source_info> _signal_sources;
 	Genode::Lock _destroyed_signal_sources_lock;
 	Genode::Fifo<Signal_source_info> _destroyed_signal_sources;
 
@@ -89,7 +117,7 @@ protected:
 	 * Signal_context_capabilities
 	 */
 	Genode::Lock _signal_contexts_lock;
-	Genode::List<Signal_context_info> _signal_contexts;
+	Badge_list<Signal_context_info> _signal_contexts;
 	Genode::Lock _destroyed_signal_contexts_lock;
 	Genode::Fifo<Signal_context_info> _destroyed_signal_contexts;
 
@@ -98,7 +126,7 @@ protected:
 	 * Native_capabilities
 	 */
 	Genode::Lock _native_caps_lock;
-	Genode::List<Native_capability_info> _native_caps;
+	Badge_list<Native_capability_info> _native_caps;
 	Genode::Lock _destroyed_native_caps_lock;
 	Genode::Fifo<Native_capability_info> _destroyed_native_caps;
 
@@ -108,11 +136,24 @@ protected:
 	 * List of allocated ram dataspaces
 	 */
 	Genode::Lock _ram_dataspaces_lock;
-	Genode::List<Ram_dataspace_info> _ram_dataspaces;
+	Badge_list<Ram_dataspace_info> _ram_dataspaces;
 
 	Genode::Lock _destroyed_ram_dataspaces_lock;
 	Genode::Fifo<Ram_dataspace_info> _destroyed_ram_dataspaces;
 
+	/**
+	 * First element of `_ram_dataspaces` which has a cold dataspace. All
+	 * following elements have one, too.
+	 */
+	Ram_dataspace_info *_cold_ram_dataspaces = nullptr;
+
+	/**
+	 * First element of `_ram_dataspaces` copied by the last checkpoint in
+	 * the double-buffered mode, which is published by
+	 * `flip_ram_dataspaces()`
+	 */
+	Ram_dataspace_info *_copied_ram_dataspaces = nullptr;
+
 
 	Genode::Env &_env;
 	/**
@@ -145,11 +186,321 @@ protected:
 
 	Child_info *_child_info;
 
+	/**
+	 * Rom dataspace holding the XML config
+	 */
+	Genode::Attached_rom_dataspace _config;
+
+	/**
+	 * Defines which memory of the Ram dataspaces is copied by a checkpoint
+	 *
+	 * * FULL copies all pages
+	 * * INCREMENTAL copies only pages written since the last checkpoint
+	 * * HASH copies only pages whose fingerprint changed since the last
+	 *   checkpoint
+	 * * COPY_ON_WRITE write-protects the pages written since the last
+	 *   checkpoint and copies them while the child is running
+	 */
+	enum Copy_mode { FULL, INCREMENTAL, HASH, COPY_ON_WRITE };
+	Copy_mode _copy_mode;
+
+	/**
+	 * Pages skipped (hits) and copied (misses) by the last checkpoint in the
+	 * hash copy mode
+	 */
+	Genode::size_t _hash_hits = 0;
+	Genode::size_t _hash_misses = 0;
+
+	/**
+	 * Reads the copy mode from the XML config
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint copy="incremental" granularity="1"/>
+	 * ```
+	 */
+	inline Copy_mode _read_copy_mode();
+	inline Genode::size_t _read_granularity();
+
+	/**
+	 * Records written pages in the incremental copy mode
+	 */
+	Genode::Constructible<Write_tracker> _write_tracker;
+
+	/**
+	 * Classifies the Ram dataspaces attached by the child. If constructed,
+	 * the memory of immutable dataspaces is not copied again.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint skip_immutable="true"/>
+	 * ```
+	 */
+	Genode::Constructible<Dataspace_classifier> _classifier;
+	inline bool _read_skip_immutable();
+
+	/**
+	 * If true, pages containing only zeros are not copied
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint zero_pages="true"/>
+	 * ```
+	 */
+	bool _zero_pages;
+	inline bool _read_zero_pages();
+
+	/**
+	 * If true, each Ram dataspace has two cold dataspaces. A checkpoint
+	 * copies into one of them, while the other one holds the last complete
+	 * checkpoint.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint double_buffered="true"/>
+	 * ```
+	 */
+	bool _double_buffered;
+	inline bool _read_double_buffered();
+
+	/**
+	 * Time in microseconds, after which the `ram_checkpointable` stops
+	 * copying. The next checkpoint continues at the recorded cursor. Zero
+	 * disables the budget.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint time_budget_us="2000"/>
+	 * ```
+	 */
+	unsigned long long _time_budget;
+	inline unsigned long long _read_time_budget();
+
+	/**
+	 * Dataspaces whose average ratio of changed pages is at least
+	 * `_hot_threshold` permille are hot. Hot dataspaces are skipped by
+	 * pre-copy rounds and copied after all other dataspaces. Zero disables
+	 * the ordering. The threshold is configured in percent.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint hot_threshold="25"/>
+	 * ```
+	 */
+	unsigned _hot_threshold;
+	inline unsigned _read_hot_threshold();
+
+	/**
+	 * Number of completed Ram checkpoints
+	 */
+	unsigned long _generation = 0;
+
+	/**
+	 * Pages of all Ram dataspaces changed between the last two completed
+	 * Ram checkpoints
+	 */
+	Genode::size_t _changed_pages = 0;
+	Genode::size_t _total_pages = 0;
+
+	/**
+	 * Pages copied by the last completed Ram checkpoint
+	 *
+	 * The changes of a dataspace are not tracked in the full copy mode, in
+	 * which all pages of a copied dataspace are counted by `_full_pages`
+	 * until the Ram checkpoint is completed.
+	 */
+	Genode::size_t _copied_pages = 0;
+	Genode::size_t _full_pages = 0;
+
+	/**
+	 * Number of checkpoints without changes, after which the cold dataspace
+	 * of a Ram dataspace is compressed and released. Zero disables the
+	 * compression. Requires the incremental copy mode.
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint copy="incremental" compress_after="4"/>
+	 * ```
+	 */
+	unsigned _compress_after;
+	inline unsigned _read_compress_after();
+
+	/**
+	 * Working memory of the compressor, which is used by the
+	 * `ram_checkpointable` only
+	 */
+	Genode::Constructible<Lz4::Hash_table> _lz4_table;
+
+	/**
+	 * Cold dataspace replaced by its compressed content, which is freed
+	 * after the checkpoint
+	 */
+	struct Retired_dataspace : Genode::List<Retired_dataspace>::Element
+	{
+		Genode::Ram_dataspace_capability const cap;
+		void * const addr;
+
+		Retired_dataspace(Genode::Ram_dataspace_capability cap, void *addr)
+			: cap(cap), addr(addr) { }
+	};
+	Genode::List<Retired_dataspace> _retired_dataspaces;
+
+	/**
+	 * Compress the cold dataspaces of stable dataspaces after a checkpoint
+	 * and free the retired cold dataspaces
+	 */
+	void _compress_stable_dataspaces();
+
+	/**
+	 * Compress the cold dataspace into `pending_compressed`
+	 */
+	void _compress_dataspace(Ram_dataspace *ds);
+
+	/**
+	 * Replace the cold dataspace by its pending compressed content
+	 */
+	void _adopt_compressed(Ram_dataspace *ds);
+
+	void _drop_compressed(Ram_dataspace *ds);
+
+	/**
+	 * Allocate a cold dataspace for the compressed content
+	 */
+	void _inflate_dataspace(Ram_dataspace *ds);
+
+	/**
+	 * Detach and free the cold dataspace or return it to the pool
+	 */
+	void _release_cold_dataspace(Ram_dataspace *ds);
+
+	bool _hot(Ram_dataspace const *ds) const {
+		return _hot_threshold && ds->changes.dirty_permille >= _hot_threshold; }
+
+	/**
+	 * Position where the next slice of a checkpoint bounded by the time
+	 * budget continues
+	 */
+	struct Ram_cursor
+	{
+		Ram_dataspace_info *ds = nullptr;
+		Genode::size_t offset = 0;
+		bool active = false;
+
+		/* true while copying the hot dataspaces */
+		bool hot = false;
+
+		/* bytes copied by the last slice */
+		Genode::size_t slice_bytes = 0;
+	} _ram_cursor;
+
+	/**
+	 * Pre-allocated cold dataspaces, which are paired with Ram dataspaces
+	 * on their allocation
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint cold_pool="4"/>
+	 * ```
+	 */
+	Genode::Constructible<Cold_pool> _cold_pool;
+	inline unsigned _read_cold_pool();
+
+	/**
+	 * Workers for copying large dataspaces in chunks
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <checkpoint copy_workers="3" chunk_size="1M"/>
+	 * ```
+	 */
+	Genode::List<Copy_worker> _copy_workers;
+	Genode::size_t _chunk_size;
+
+	inline unsigned _read_copy_workers();
+	inline Genode::size_t _read_chunk_size();
+
+	/**
+	 * Dataspace which is currently copied by the workers and the offset of
+	 * its next chunk
+	 */
+	Genode::Lock _copy_lock;
+	Ram_dataspace *_chunk_ds = nullptr;
+	Genode::size_t _chunk_offset = 0;
+
 	void _checkpoint_signal_sources();
 	void _checkpoint_signal_contexts();
 	void _checkpoint_native_capabilities();
 	void _checkpoint_ram_dataspaces();	
 
+	/**
+	 * Remove destroyed dataspaces and allocate cold dataspaces before, and
+	 * publish the copied dataspaces after copying a checkpoint
+	 */
+	void _begin_ram_checkpoint();
+	void _end_ram_checkpoint();
+
+	/**
+	 * Copy chunks of the Ram dataspaces from `_ram_cursor` until the time
+	 * budget is used up
+	 */
+	void _checkpoint_ram_slice();
+
+	/**
+	 * Destroy the cold dataspaces of dataspaces freed by the child
+	 */
+	void _remove_destroyed_dataspaces();
+
+	/**
+	 * Allocate and attach cold dataspaces for recently added dataspaces
+	 */
+	void _alloc_cold_dataspaces();
+
+	/**
+	 * Allocate and attach the second cold dataspace in the double-buffered
+	 * mode
+	 */
+	void _alloc_front_dataspace(Ram_dataspace *ds);
+
+	/**
+	 * Copy the pages write-protected by `snapshot_ram_dataspaces()`
+	 */
+	void _copy_snapshot();
+
+	/**
+	 * Copy the memory of `ds` from `offset` to `offset + size` according to
+	 * the copy mode
+	 *
+	 * \param offset  page-aligned offset within `ds`
+	 */
+	void _copy_range(Ram_dataspace *ds, Genode::size_t offset, Genode::size_t size);
+
+	/**
+	 * Copy the pages of a range whose fingerprint differs from the
+	 * fingerprint of the cold copy
+	 */
+	void _copy_changed_pages(Ram_dataspace *ds, Genode::size_t offset, Genode::size_t size);
+
+	/**
+	 * Prepare copying `ds` according to the copy mode
+	 *
+	 * \return false, if the memory of `ds` is not copied
+	 */
+	bool _begin_copy(Ram_dataspace *ds);
+
+	/**
+	 * Copy chunks of `_chunk_ds` until all chunks are taken
+	 */
+	void _copy_chunks();
+
 
 	virtual void _destroy_dataspace(Ram_dataspace *ds);
 	virtual void _attach_dataspace(Ram_dataspace *ds);
@@ -177,6 +528,112 @@ public:
 
 	Region_map &address_space_component() { return _address_space; }
 
+	/**
+	 * Copy the pages of all Ram dataspaces written since the last copy
+	 * while the child keeps running
+	 *
+	 * Only supported in the incremental copy mode. The remaining dirty pages
+	 * are copied by the next checkpoint.
+	 *
+	 * \return number of copied pages
+	 */
+	Genode::size_t precopy_ram_dataspaces();
+
+	/**
+	 * Write-protect the pages of all Ram dataspaces written since the last
+	 * checkpoint
+	 *
+	 * Only supported in the copy-on-write mode. The child must be paused.
+	 * After the child is resumed, `ram_checkpointable` copies the protected
+	 * pages. A page written by the child before is copied on the fault.
+	 */
+	void snapshot_ram_dataspaces();
+
+	bool snapshot_mode() const { return _copy_mode == COPY_ON_WRITE; }
+
+	bool zero_pages_elided() const { return _zero_pages; }
+
+	bool double_buffered() const { return _double_buffered; }
+
+	bool time_bounded() const { return _time_budget != 0; }
+
+	bool hot_ordering() const { return _hot_threshold != 0; }
+
+	bool compression() const { return _compress_after != 0; }
+
+	/**
+	 * Compressed cold dataspaces and the size of their content
+	 */
+	Genode::size_t compressed_dataspaces();
+	Genode::size_t compressed_bytes();
+
+	/**
+	 * \return pages changed between the last two completed Ram checkpoints
+	 */
+	Genode::size_t changed_pages() const { return _changed_pages; }
+
+	/**
+	 * \return pages copied by the last completed Ram checkpoint
+	 */
+	Genode::size_t copied_pages() const { return _copied_pages; }
+
+	/**
+	 * \return pages not copied by the last completed Ram checkpoint
+	 */
+	Genode::size_t skipped_pages() const {
+		return _total_pages > _copied_pages ? _total_pages - _copied_pages : 0; }
+
+	/**
+	 * \return number of hot Ram dataspaces
+	 */
+	Genode::size_t hot_dataspaces();
+
+	/**
+	 * \return true, if the last checkpoint copied all Ram dataspaces
+	 */
+	bool ram_checkpoint_complete() const { return !_ram_cursor.active; }
+
+	/**
+	 * \return bytes copied by the last checkpoint bounded by the time budget
+	 */
+	Genode::size_t ram_slice_bytes() const { return _ram_cursor.slice_bytes; }
+
+	/**
+	 * \return tracker of written pages or nullptr, if neither the
+	 *         incremental nor the copy-on-write mode is used
+	 */
+	Write_tracker *write_tracker() {
+		return _write_tracker.constructed() ? &*_write_tracker : nullptr; }
+
+	/**
+	 * \return classifier of Ram dataspaces or nullptr, if immutable
+	 *         dataspaces are not skipped
+	 */
+	Dataspace_classifier *dataspace_classifier() {
+		return _classifier.constructed() ? &*_classifier : nullptr; }
+
+	/**
+	 * \return number of immutable Ram dataspaces
+	 */
+	Genode::size_t immutable_dataspaces();
+
+	/**
+	 * Publish the Ram dataspaces copied by the last checkpoint in the
+	 * double-buffered mode
+	 *
+	 * Must be called after all checkpointables joined and while the last
+	 * checkpoint is not serialized.
+	 */
+	void flip_ram_dataspaces();
+
+	/**
+	 * \return number of zero pages of all Ram dataspaces
+	 */
+	Genode::size_t zero_pages();
+	bool hash_mode() const { return _copy_mode == HASH; }
+	Genode::size_t hash_hits() const { return _hash_hits; }
+	Genode::size_t hash_misses() const { return _hash_misses; }
+
 	// Region_map const &address_space_component() const { return _address_space; }
 
 	// Region_map &stack_area_component() { return _stack_area; }
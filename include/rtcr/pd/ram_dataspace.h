@@ -12,10 +12,15 @@
 #include <util/list.h>
 #include <util/fifo.h>
 #include <region_map/client.h>
+#include <util/reconstructible.h>
 
 /* Rtcr includes */
 #include <rtcr/pd/ram_dataspace_info.h>
 #include <rtcr/info_structs.h>
+#include <util/bitmap.h>
+#include <util/page_hash.h>
+#include <util/zero_page.h>
+#include <util/copy_engine.h>
 
 namespace Rtcr {
 	class Ram_dataspace;
@@ -29,12 +34,192 @@ class Rtcr::Ram_dataspace : private Simple_counter<Ram_dataspace>,
 							public Ram_dataspace_info
 {
 public:	
+	enum { PAGE_SIZE = 4096 };
+
 	/* pointers where ds are attached */
 	void *src = nullptr;
 	void *dst = nullptr;
 		
 	bool bootstrapped;
 
+	/**
+	 * True, if a cold dataspace is allocated and attached to `dst`
+	 */
+	bool cold_allocated = false;
+
+	/**
+	 * Size of the cold dataspace, which exceeds `i_size` if it was taken
+	 * from a size class of the `Cold_pool`
+	 */
+	Genode::size_t cold_size = 0;
+
+	/**
+	 * Pages written since they were write-protected the last time. Only
+	 * maintained in the incremental copy mode.
+	 */
+	Genode::Constructible<Bitmap> dirty_pages;
+
+	/**
+	 * Pages which are copied by the current checkpoint. Only maintained in
+	 * the incremental copy mode.
+	 */
+	Genode::Constructible<Bitmap> copy_pages;
+
+	/**
+	 * Fingerprints of the pages stored in the cold dataspace. Only
+	 * maintained in the hash copy mode.
+	 */
+	Genode::Constructible<Fingerprint_table> fingerprints;
+
+	/**
+	 * Backing store of `i_zero_pages`. Only maintained if zero pages are
+	 * elided.
+	 */
+	Genode::Constructible<Bitmap> zero_pages;
+
+	/**
+	 * Mutability derived from the attachments to the child's region maps
+	 *
+	 * The content of an immutable dataspace is copied only by the first
+	 * checkpoint after its classification, or by the first two checkpoints
+	 * in the double-buffered mode. `immutable_copies` counts these copies.
+	 */
+	enum Mutability { UNCLASSIFIED, IMMUTABLE, MUTABLE };
+	Mutability mutability = UNCLASSIFIED;
+	unsigned immutable_copies = 0;
+
+	/**
+	 * True, if compressing the cold dataspace did not save memory. Reset
+	 * when the dataspace changes.
+	 */
+	bool incompressible = false;
+
+	/**
+	 * Content of the cold dataspace compressed after the last checkpoint.
+	 * It replaces the cold dataspace at the next checkpoint, if the
+	 * dataspace is still unchanged.
+	 */
+	void *pending_compressed = nullptr;
+	Genode::size_t pending_compressed_size = 0;
+
+	/**
+	 * Pages changed across checkpoints. Only maintained in the incremental,
+	 * copy-on-write, and hash copy modes.
+	 */
+	struct Change_stats
+	{
+		/* pages changed since the last checkpoint, including pre-copy rounds */
+		Genode::size_t pages = 0;
+
+		/* moving average of the ratio of changed pages in permille */
+		unsigned dirty_permille = 0;
+
+		/* last checkpoint which changed a page */
+		unsigned long last_changed = 0;
+
+		void update(unsigned long generation, Genode::size_t num_pages)
+		{
+			unsigned const ratio = num_pages
+				? (unsigned)Genode::min(pages*1000 / num_pages, (Genode::size_t)1000) : 0;
+			dirty_permille = (3*dirty_permille + ratio) / 4;
+			if(pages) last_changed = generation;
+			pages = 0;
+		}
+	} changes;
+
+	/**
+	 * Cold dataspace attached to `dst`
+	 */
+	Genode::Ram_dataspace_capability dst_cap;
+
+	/**
+	 * Cold dataspace of the last complete checkpoint in the double-buffered
+	 * mode. A checkpoint copies into `dst`. Afterwards, `flip()` exchanges
+	 * both cold dataspaces.
+	 */
+	Genode::Ram_dataspace_capability front_cap;
+	void *front = nullptr;
+	Genode::size_t front_size = 0;
+	Genode::Constructible<Bitmap> front_zero_pages;
+	Genode::Constructible<Fingerprint_table> front_fingerprints;
+
+	/**
+	 * Pages copied into `front` but not into `dst` and pages copied into
+	 * `dst` since the last flip. Only maintained in the double-buffered
+	 * incremental copy mode.
+	 */
+	Genode::Constructible<Bitmap> missed_pages;
+	Genode::Constructible<Bitmap> copied_pages;
+
+	Genode::size_t num_pages() const { return (i_size + PAGE_SIZE - 1) / PAGE_SIZE; }
+
+	/**
+	 * Copy memory from `src` to `dst`
+	 *
+	 * If zero pages are elided, pages containing only zeros are recorded in
+	 * `zero_pages` instead of being copied.
+	 *
+	 * \param offset  page-aligned offset
+	 */
+	void copy(Genode::size_t offset, Genode::size_t size)
+	{
+		if(!zero_pages.constructed()) {
+			copy_memory((char*)dst + offset, (char*)src + offset, size);
+			return;
+		}
+
+		/* copy runs of pages which are not zero at once */
+		Genode::size_t run = offset;
+		Genode::size_t const end = offset + size;
+		for(Genode::size_t page = offset; page < end; page += PAGE_SIZE) {
+			Genode::size_t const page_size = Genode::min((Genode::size_t)PAGE_SIZE, end - page);
+			if(!is_zero((char*)src + page, page_size)) {
+				zero_pages->clear(page / PAGE_SIZE);
+				continue;
+			}
+
+			zero_pages->set(page / PAGE_SIZE);
+			if(run < page)
+				copy_memory((char*)dst + run, (char*)src + run, page - run);
+			run = page + PAGE_SIZE;
+		}
+		if(run < end)
+			copy_memory((char*)dst + run, (char*)src + run, end - run);
+	}
+
+	/**
+	 * Publish `dst` as the last complete checkpoint and reuse `front` for
+	 * the next checkpoint
+	 */
+	void flip()
+	{
+		void *addr = dst;
+		dst = front;
+		front = addr;
+
+		Genode::Ram_dataspace_capability cap = dst_cap;
+		dst_cap = front_cap;
+		front_cap = cap;
+
+		Genode::size_t const size = cold_size;
+		cold_size = front_size;
+		front_size = size;
+
+		if(zero_pages.constructed() && front_zero_pages.constructed())
+			zero_pages->swap(*front_zero_pages);
+		if(fingerprints.constructed() && front_fingerprints.constructed())
+			fingerprints->swap(*front_fingerprints);
+
+		/* the pages copied into the new front are missing in the new dst */
+		if(missed_pages.constructed()) {
+			missed_pages->swap(*copied_pages);
+			copied_pages->clear_all();
+		}
+
+		i_dst_cap = front_cap;
+		i_zero_pages = front_zero_pages.constructed() ? &*front_zero_pages : nullptr;
+	}
+
 	void checkpoint() {
 //		i_timestamp = timestamp();
 	}
@@ -14,6 +14,7 @@
 
 /* Rtcr includes */
 #include <rtcr/info_structs.h>
+#include <util/bitmap.h>
 
 
 namespace Rtcr {
@@ -34,6 +35,19 @@ public:
 	Genode::size_t                   i_size;
 	Genode::Cache_attribute          i_cached;
 
+	/**
+	 * Pages which contain only zeros and are not stored in the cold
+	 * dataspace. If nullptr, all pages are stored.
+	 */
+	Bitmap                          *i_zero_pages = nullptr;
+
+	/**
+	 * Content of the cold dataspace in the LZ4 block format. If not
+	 * nullptr, `i_dst_cap` is invalid.
+	 */
+	void const                      *i_compressed = nullptr;
+	Genode::size_t                   i_compressed_size = 0;
+
 	Ram_dataspace_info(Genode::Ram_dataspace_capability const src_cap,
 					   Genode::size_t const size,
 					   Genode::Cache_attribute const cached)
@@ -53,11 +67,16 @@ public:
 				  ", timestamp=", i_timestamp, "\n");
 	}
 
+	/**
+	 * \return key of the info in a `Badge_list`, the badge of the dataspace
+	 */
+	Genode::uint16_t badge() const { return i_src_cap.local_name(); }
+
 	Ram_dataspace_info *find_by_badge(Genode::uint16_t badge) {
-		if(badge == i_src_cap.local_name())
-			return this;
-		Ram_dataspace_info *info = next();
-		return info ? info->find_by_badge(badge) : 0;
+		Ram_dataspace_info *info = this;
+		while(info && badge != info->badge())
+			info = info->next();
+		return info;
 	}
 
 	Ram_dataspace_info *find_by_timestamp(Genode::size_t timestamp) {
@@ -48,10 +48,10 @@ public:
 	}
 
 	Signal_context_info *find_by_badge(Genode::uint16_t badge) {
-		if(badge == i_badge)
-			return this;
-		Signal_context_info *info = next();
-		return info ? info->find_by_badge(badge) : 0;
+		Signal_context_info *info = this;
+		while(info && badge != info->i_badge)
+			info = info->next();
+		return info;
 	}
 };
 
@@ -30,10 +30,10 @@ public:
 	Signal_source_info() {};
 
 	Signal_source_info *find_by_badge(Genode::uint16_t badge) {
-		if(badge == i_badge)
-			return this;
-		Signal_source_info *info = next();
-		return info ? info->find_by_badge(badge) : 0;
+		Signal_source_info *info = this;
+		while(info && badge != info->i_badge)
+			info = info->next();
+		return info;
 	}
 };
 
@@ -0,0 +1,73 @@
+/*
+ * \brief  Automatic placement of checkpoint threads
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_PLACEMENT_H_
+#define _RTCR_PLACEMENT_H_
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/affinity.h>
+#include <base/lock.h>
+#include <base/attached_rom_dataspace.h>
+#include <util/xml_node.h>
+
+namespace Rtcr {
+	class Placement;
+}
+
+
+/**
+ * Places checkpoint threads on the cores of the affinity space
+ *
+ * The cores of the childs, as given by the `child` nodes of the
+ * configuration, are avoided as long as other cores exist. Each thread is
+ * placed on the core with the lowest expected cost of the threads placed so
+ * far. The expected cost of a thread is taken from the `stage` node whose
+ * name is a prefix of the thread name, e.g. the mean latencies of a report
+ * of a previous run. Threads without `stage` node cost 1.
+ *
+ * Example configuration:
+ *
+ * ```XML
+ * <placement mode="auto">
+ *   <stage name="ram_dataspaces" cost="1800"/>
+ *   <stage name="ram_copy_worker" cost="1200"/>
+ *   <stage name="capability_mapping" cost="300"/>
+ * </placement>
+ * ```
+ */
+class Rtcr::Placement
+{
+private:
+
+	enum { MAX_CORES = 64 };
+
+	Genode::Attached_rom_dataspace _config;
+
+	unsigned const _width;
+	unsigned const _height;
+	unsigned const _cores;
+
+	Genode::Lock _lock;
+	bool _child_core[MAX_CORES];
+	unsigned long long _load[MAX_CORES];
+
+	/**
+	 * \return expected cost of the thread named `name`
+	 */
+	unsigned long long _cost(char const *name) const;
+
+public:
+
+	Placement(Genode::Env &env);
+
+	/**
+	 * \return location of the thread named `name`
+	 */
+	Genode::Affinity::Location place(char const *name);
+};
+
+#endif /* _RTCR_PLACEMENT_H_ */
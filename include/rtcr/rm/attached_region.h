@@ -26,6 +26,12 @@ class Rtcr::Attached_region : public Rtcr::Attached_region_info
 public:
 	const Genode::Dataspace_capability attached_ds_cap;
 	bool bootstrapped;
+
+	/**
+	 * Managed dataspace which is attached instead of `attached_ds_cap`, if
+	 * the writes to this region are tracked
+	 */
+	Genode::Dataspace_capability managed_ds_cap;
  
 	Attached_region(Genode::Dataspace_capability attached_ds_cap,
 	                Genode::size_t size,
@@ -11,6 +11,7 @@
 /* Genode includes */
 #include <util/list.h>
 #include <util/fifo.h>
+#include <util/avl_tree.h>
 #include <dataspace/capability.h>
 
 /* Rtcr includes */
@@ -23,7 +24,8 @@ namespace Rtcr {
 
 class Rtcr::Attached_region_info : public Rtcr::Normal_info,
                                    public Genode::List<Attached_region_info>::Element,
-                                   public Genode::Fifo<Attached_region_info>::Element
+                                   public Genode::Fifo<Attached_region_info>::Element,
+                                   public Genode::Avl_node<Attached_region_info>
 {
 public:
 	using Genode::List<Attached_region_info>::Element::next;
@@ -70,17 +72,41 @@ public:
 
 
 	Attached_region_info *find_by_addr(Genode::addr_t addr) {
-		if((addr >= i_rel_addr) && (addr <= i_rel_addr + i_size))
-			return this;
-		Attached_region_info *info = next();
-		return info ? info->find_by_addr(addr) : 0;
+		Attached_region_info *info = this;
+		while(info && !((addr >= info->i_rel_addr) && (addr <= info->i_rel_addr + info->i_size)))
+			info = info->next();
+		return info;
 	}
 
 	Attached_region_info *find_by_badge(Genode::uint16_t badge) {
-		if(badge == i_badge)
-			return this;
-		Attached_region_info *info = next();
-		return info ? info->find_by_badge(badge) : 0;
+		Attached_region_info *info = this;
+		while(info && badge != info->i_badge)
+			info = info->next();
+		return info;
+	}
+
+	/**
+	 * Avl_node interface, the attachments are ordered by their address
+	 */
+	bool higher(Attached_region_info *other) { return other->i_rel_addr > i_rel_addr; }
+
+	/**
+	 * \return attachment of this subtree containing `addr` or nullptr
+	 *
+	 * The attachments of a region map do not overlap, therefore the search
+	 * descends along a single path.
+	 */
+	Attached_region_info *find_in_tree(Genode::addr_t addr) {
+		Attached_region_info *info = this;
+		while(info) {
+			if(addr < info->i_rel_addr)
+				info = info->child(LEFT);
+			else if(addr < info->i_rel_addr + info->i_size)
+				return info;
+			else
+				info = info->child(RIGHT);
+		}
+		return nullptr;
 	}
 
 };
@@ -0,0 +1,67 @@
+/*
+ * \brief  Classification of Ram dataspaces by their attachments
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_DATASPACE_CLASSIFIER_H_
+#define _RTCR_DATASPACE_CLASSIFIER_H_
+
+/* Genode includes */
+#include <base/lock.h>
+#include <util/list.h>
+#include <dataspace/capability.h>
+
+/* Rtcr includes */
+#include <rtcr/pd/ram_dataspace.h>
+#include <rtcr/pd/ram_dataspace_info.h>
+#include <util/badge_list.h>
+
+namespace Rtcr {
+	class Dataspace_classifier;
+}
+
+
+/**
+ * Classifies the Ram dataspaces of a child by the attachments to its region
+ * maps
+ *
+ * A Ram dataspace is immutable, if it is attached only non-writeable, like
+ * the text segment of a binary. It becomes mutable on its first writeable
+ * attachment, including a writeable and executable one, and stays mutable. Dataspaces not attached yet
+ * are not classified.
+ */
+class Rtcr::Dataspace_classifier
+{
+private:
+	Genode::Lock &_ram_dataspaces_lock;
+	Badge_list<Ram_dataspace_info> &_ram_dataspaces;
+
+public:
+	Dataspace_classifier(Genode::Lock &ram_dataspaces_lock,
+	                     Badge_list<Ram_dataspace_info> &ram_dataspaces)
+		:
+		_ram_dataspaces_lock(ram_dataspaces_lock),
+		_ram_dataspaces(ram_dataspaces)
+	{ }
+
+	/**
+	 * Classify `ds_cap` by an attachment to a region map of the child
+	 *
+	 * Dataspaces which were not allocated by the child are ignored.
+	 */
+	void attached(Genode::Dataspace_capability ds_cap, bool writeable)
+	{
+		Genode::Lock::Guard guard(_ram_dataspaces_lock);
+		Ram_dataspace_info *info = _ram_dataspaces.find_by_badge(ds_cap.local_name());
+		if(!info) return;
+
+		Ram_dataspace &ds = *static_cast<Ram_dataspace*>(info);
+		if(writeable)
+			ds.mutability = Ram_dataspace::MUTABLE;
+		else if(ds.mutability == Ram_dataspace::UNCLASSIFIED)
+			ds.mutability = Ram_dataspace::IMMUTABLE;
+	}
+};
+
+#endif /* _RTCR_DATASPACE_CLASSIFIER_H_ */
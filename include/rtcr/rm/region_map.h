@@ -18,6 +18,8 @@
 /* Rtcr includes */
 #include <rtcr/rm/attached_region.h>
 #include <rtcr/rm/region_map_info.h>
+#include <rtcr/rm/write_tracker.h>
+#include <rtcr/rm/dataspace_classifier.h>
 
 namespace Rtcr {
 	class Region_map;
@@ -70,6 +72,14 @@ protected:
 	Genode::Lock _attached_regions_lock;
 	Genode::List<Attached_region_info> _attached_regions;
 
+	/**
+	 * Attachments which are not detached yet, ordered by their address
+	 *
+	 * Detached regions stay in `_attached_regions` until the next
+	 * checkpoint, but are removed from this tree by `detach()`.
+	 */
+	Genode::Avl_tree<Attached_region_info> _attached_region_tree;
+
 	/**
 	 * Allocator for Region map's attachments
 	 */
@@ -85,6 +95,17 @@ protected:
 	 */
 	const char* _label;
 
+	/**
+	 * Tracker of written pages, if the incremental copy mode is used
+	 */
+	Write_tracker *_write_tracker = nullptr;
+
+	/**
+	 * Classifier of the attached Ram dataspaces, if immutable dataspaces
+	 * are skipped
+	 */
+	Dataspace_classifier *_classifier = nullptr;
+
 public:
 
 	Region_map(Genode::Allocator &md_alloc,
@@ -106,9 +127,30 @@ public:
 
 	void checkpoint();
 
+	/**
+	 * Track the writes to Ram dataspaces attached from now on
+	 */
+	void write_tracker(Write_tracker *tracker) { _write_tracker = tracker; }
+
+	/**
+	 * Classify Ram dataspaces attached from now on
+	 */
+	void classifier(Dataspace_classifier *classifier) { _classifier = classifier; }
+
 	/* This function is implemented for capability_mapping.cc */
 	Attached_region *find_attached_region_by_addr(Genode::addr_t addr);
 
+	/**
+	 * Call `fn` for each attached region in the order of their addresses
+	 */
+	template <typename FN>
+	void for_each_attached_region(FN const &fn)
+	{
+		Genode::Lock::Guard lock_guard(_attached_regions_lock);
+		_attached_region_tree.for_each([&] (Attached_region_info const &region) {
+			fn(static_cast<Attached_region const &>(region)); });
+	}
+
 	/******************************
 	 ** Region map Rpc interface **
 	 ******************************/
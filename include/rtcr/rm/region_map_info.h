@@ -53,10 +53,10 @@ public:
 	}
 
 	Region_map_info *find_by_badge(Genode::uint16_t badge) {
-		if(badge == i_badge)
-			return this;
-		Region_map_info *obj = next();
-		return obj ? obj->find_by_badge(badge) : 0;
+		Region_map_info *info = this;
+		while(info && badge != info->i_badge)
+			info = info->next();
+		return info;
 	}
 
 };
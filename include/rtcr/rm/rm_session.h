@@ -20,6 +20,7 @@
 #include <rtcr/rm/region_map.h>
 #include <rtcr/rm/rm_session_info.h>
 #include <rtcr/child_info.h>
+#include <util/badge_list.h>
 
 namespace Rtcr {
 	class Rm_session;
@@ -37,7 +38,7 @@ protected:
 	const char* _upgrade_args;
 	Genode::Lock _region_maps_lock;
 	Genode::Lock _destroyed_region_maps_lock;
-	Genode::List<Region_map_info> _region_maps;
+	Badge_list<Region_map_info> _region_maps;
 	Genode::Fifo<Region_map_info> _destroyed_region_maps;
 
 	/**
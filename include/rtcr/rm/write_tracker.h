@@ -0,0 +1,197 @@
+/*
+ * \brief  Tracking of written pages of Ram dataspaces
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_WRITE_TRACKER_H_
+#define _RTCR_WRITE_TRACKER_H_
+
+/* Genode includes */
+#include <base/env.h>
+#include <base/allocator.h>
+#include <base/entrypoint.h>
+#include <base/signal.h>
+#include <base/lock.h>
+#include <util/list.h>
+#include <rm_session/connection.h>
+#include <region_map/client.h>
+
+/* Rtcr includes */
+#include <rtcr/pd/ram_dataspace.h>
+#include <rtcr/pd/ram_dataspace_info.h>
+#include <util/bitmap.h>
+#include <util/badge_list.h>
+
+namespace Rtcr {
+	class Write_tracker;
+}
+
+
+/**
+ * Records the pages of Ram dataspaces written by the child
+ *
+ * Instead of the Ram dataspace itself, a managed dataspace is attached into
+ * the child's region map. The granules of the Ram dataspace are attached into
+ * this managed dataspace on their first access, which is signaled by a region
+ * map fault. A read fault attaches a granule read-only and leaves its pages
+ * clean. A write fault marks all pages of the granule dirty and attaches it
+ * writeable. `protect()` detaches the writeable granules again. Therefore, all
+ * pages of a granule written between two calls of `protect()` are marked
+ * dirty.
+ */
+class Rtcr::Write_tracker
+{
+private:
+
+	/**
+	 * Attachment of a Ram dataspace, which is backed by a managed dataspace
+	 */
+	struct Tracked_region : Genode::List<Tracked_region>::Element
+	{
+		Write_tracker &_tracker;
+		Ram_dataspace &ds;
+
+		/**
+		 * Page-aligned offset and size of the attachment within `ds`
+		 */
+		Genode::off_t const offset;
+		Genode::size_t const size;
+
+		/**
+		 * Granules are attached executable, if the child attached the
+		 * region executable
+		 */
+		bool const executable;
+
+		Genode::Capability<Genode::Region_map> const rm_cap;
+		Genode::Region_map_client rm;
+		Genode::Dataspace_capability const managed_ds_cap;
+
+		/**
+		 * Granules which are currently attached and those of them which are
+		 * attached writeable
+		 */
+		Bitmap attached;
+		Bitmap writeable;
+
+		Genode::Signal_handler<Tracked_region> _fault_handler;
+
+		void _handle_fault();
+
+		Tracked_region(Write_tracker &tracker,
+		               Ram_dataspace &ds,
+		               Genode::off_t offset,
+		               Genode::size_t size,
+		               bool executable);
+
+		/**
+		 * Detach all writeable granules
+		 */
+		void protect();
+	};
+
+	Genode::Env        &_env;
+	Genode::Allocator  &_alloc;
+	Genode::Entrypoint &_ep;
+
+	/**
+	 * Connection for creating the managed dataspaces
+	 */
+	Genode::Rm_connection _rm;
+
+	/**
+	 * Number of pages which are attached at once on a fault
+	 */
+	Genode::size_t const _granularity;
+
+	/**
+	 * Ram dataspaces of the Pd session which are tracked
+	 */
+	Genode::Lock &_ram_dataspaces_lock;
+	Badge_list<Ram_dataspace_info> &_ram_dataspaces;
+
+	/**
+	 * Protects the regions and the `dirty_pages` of all tracked dataspaces
+	 */
+	Genode::Lock _lock;
+	Genode::List<Tracked_region> _regions;
+
+	/**
+	 * If true, pages of `copy_pages` are copied before they become
+	 * writeable
+	 */
+	bool const _copy_on_write;
+
+	Genode::size_t _granule_size() const { return _granularity*Ram_dataspace::PAGE_SIZE; }
+
+	/**
+	 * Copy the pages of `copy_pages` within a range and remove them from
+	 * `copy_pages`. The caller must hold `_lock`.
+	 */
+	void _copy_pages(Ram_dataspace &ds, Genode::size_t first, Genode::size_t count);
+
+	void _destroy(Tracked_region *region);
+
+public:
+
+	Write_tracker(Genode::Env &env,
+	              Genode::Allocator &alloc,
+	              Genode::Entrypoint &ep,
+	              Genode::Lock &ram_dataspaces_lock,
+	              Badge_list<Ram_dataspace_info> &ram_dataspaces,
+	              Genode::size_t granularity,
+	              bool copy_on_write = false);
+
+	~Write_tracker();
+
+	Genode::size_t granularity() const { return _granularity; }
+
+	/**
+	 * Start tracking an attachment
+	 *
+	 * \param ds_cap  dataspace which the child attaches
+	 * \param size    page-aligned size of the attachment
+	 * \param offset  offset of the attachment within `ds_cap`
+	 * \param executable  true, if the child attaches `ds_cap` executable
+	 *
+	 * \return managed dataspace, which has to be attached instead of
+	 *         `ds_cap`, or an invalid capability if `ds_cap` is no tracked
+	 *         Ram dataspace.
+	 */
+	Genode::Dataspace_capability track(Genode::Dataspace_capability ds_cap,
+	                                   Genode::size_t size,
+	                                   Genode::off_t offset,
+	                                   bool executable = false);
+
+	/**
+	 * Stop tracking the attachment of a managed dataspace
+	 */
+	void untrack(Genode::Dataspace_capability managed_ds_cap);
+
+	/**
+	 * Stop tracking all attachments of `ds`
+	 */
+	void untrack(Ram_dataspace &ds);
+
+	/**
+	 * Write-protect all attachments of `ds`
+	 *
+	 * The dirty pages of `ds` are moved to `ds.copy_pages`. Pages written
+	 * after this call are recorded in `ds.dirty_pages` again.
+	 */
+	void protect(Ram_dataspace &ds);
+
+	/**
+	 * Copy all pages of `ds.copy_pages` from `ds.src` to `ds.dst`
+	 *
+	 * In the copy-on-write mode, the child keeps running meanwhile. A page
+	 * written by the child is copied by the fault handler before it becomes
+	 * writeable. Therefore, the pages are copied in small chunks, which
+	 * delay a fault only shortly.
+	 */
+	void copy(Ram_dataspace &ds);
+};
+
+
+#endif /* _RTCR_WRITE_TRACKER_H_ */
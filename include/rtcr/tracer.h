@@ -0,0 +1,116 @@
+/*
+ * \brief  Timeline of the checkpoint phases
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_TRACER_H_
+#define _RTCR_TRACER_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <base/lock.h>
+#include <base/thread.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
+
+namespace Rtcr {
+	class Tracer;
+}
+
+
+/**
+ * Ring buffer of begin and end events of the checkpoint phases
+ *
+ * Each event records the calling thread and its core. `dump` publishes the
+ * buffered events in the Chrome trace format as report `rtcr_trace`, which
+ * can be opened by chrome://tracing or Perfetto. If the buffer is full, the
+ * oldest events are overwritten.
+ *
+ * The tracer is created by the `Init_module`, if the configuration contains
+ * a `trace` node:
+ *
+ * ```XML
+ * <trace entries="4096"/>
+ * ```
+ */
+class Rtcr::Tracer
+{
+public:
+
+	/**
+	 * Traces the lifetime of a scope as phase `name`
+	 *
+	 * Does nothing, if tracing is disabled.
+	 */
+	struct Scope
+	{
+		char const *_name;
+
+		Scope(char const *name) : _name(name) {
+			if(Tracer *t = Tracer::current()) t->begin(_name); }
+
+		~Scope() {
+			if(Tracer *t = Tracer::current()) t->end(_name); }
+	};
+
+private:
+
+	enum { MAX_THREADS = 64 };
+
+	struct Event
+	{
+		char name[32];
+		unsigned long long time;
+		unsigned tid;
+		long core;
+		bool begin;
+	};
+
+	Genode::Allocator &_alloc;
+	Timer::Connection _timer;
+	Genode::Reporter _reporter;
+
+	Genode::Lock _lock;
+	Genode::size_t const _capacity;
+	Event *_events;
+	Genode::size_t _next = 0;
+	Genode::size_t _count = 0;
+
+	/* threads which recorded events, the index is the thread ID */
+	Genode::Thread const *_threads[MAX_THREADS];
+	unsigned _num_threads = 0;
+
+	unsigned _tid(Genode::Thread const *thread);
+
+	void _record(char const *name, bool begin);
+
+	static Tracer *&_current();
+
+	/* not copyable */
+	Tracer(Tracer const &);
+	Tracer &operator = (Tracer const &);
+
+public:
+
+	/**
+	 * \param entries  number of buffered events
+	 */
+	Tracer(Genode::Env &env, Genode::Allocator &alloc, Genode::size_t entries);
+	~Tracer();
+
+	/**
+	 * \return tracer of this component or nullptr, if tracing is disabled
+	 */
+	static Tracer *current() { return _current(); }
+
+	void begin(char const *name) { _record(name, true); }
+	void end(char const *name) { _record(name, false); }
+
+	/**
+	 * Publish all buffered events
+	 */
+	void dump();
+};
+
+#endif /* _RTCR_TRACER_H_ */
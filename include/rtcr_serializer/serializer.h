@@ -46,13 +46,29 @@ protected:
 		Genode::size_t size;
 		void *addr;
 		Genode::Dataspace_capability cap;
+		/* offset of the attached part within `cap` */
+		Genode::off_t ds_offset = 0;
 
 		Attachment(Genode::Dataspace_capability _cap, Genode::size_t _size, Pb::Attachment *_pb)
 			: pb(_pb), size(_size), cap(_cap) {};
+		Attachment(Genode::Dataspace_capability _cap, Genode::size_t _size,
+		           Genode::off_t _ds_offset, Pb::Attachment *_pb)
+			: pb(_pb), size(_size), cap(_cap), ds_offset(_ds_offset) {};
 		Attachment(Genode::Dataspace_capability _cap, Genode::size_t _size)
 			: pb(nullptr), size(_size), cap(_cap) {};
 
 		Attachment() {};
+		virtual ~Attachment() {};
+	};
+
+	/**
+	 * Temporary dataspace holding the decompressed content of a cold
+	 * dataspace during serialization
+	 */
+	struct Inflated_dataspace : Genode::List<Inflated_dataspace>::Element {
+		Genode::Ram_dataspace_capability cap;
+
+		Inflated_dataspace(Genode::Ram_dataspace_capability _cap) : cap(_cap) {};
 	};
 
 	struct Rom_attachment : Attachment {
@@ -82,6 +98,18 @@ protected:
 	const Genode::size_t _PAGE_SIZE = 4096;
 	inline Genode::size_t page_aligned_size(Genode::size_t size);
 
+	/**
+	 * Dataspaces allocated by `cold_dataspace()`
+	 */
+	Genode::List<Inflated_dataspace> _inflated;
+
+	/**
+	 * \return dataspace holding the checkpointed memory of `info`, which is
+	 *         decompressed into a temporary dataspace if necessary
+	 */
+	Genode::Dataspace_capability cold_dataspace(Ram_dataspace_info *info);
+	void free_inflated();
+
 	/**
 	 * compressing and serializing
 	 */
@@ -0,0 +1,180 @@
+/*
+ * \brief  List of monitored objects with an index over their badges
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_BADGE_LIST_H_
+#define _RTCR_BADGE_LIST_H_
+
+/* Genode includes */
+#include <util/list.h>
+#include <util/noncopyable.h>
+#include <base/allocator.h>
+#include <base/stdint.h>
+
+namespace Rtcr {
+	template<typename T> class Badge_list;
+}
+
+
+/**
+ * List which additionally keeps an open-addressing hash table over the
+ * badges of its elements
+ *
+ * The elements are the info objects of the monitored capabilities, which
+ * are looked up by the badge of the capability in RPCs like `free` or
+ * `free_context`. `T` must provide the badge by `T::badge()`. If several
+ * elements have the same badge, e.g. a capability was freed but its info is
+ * not removed until the next checkpoint, the element inserted last is
+ * found, like by a walk over the list.
+ *
+ * The list must only be modified by `insert` and `remove` of this class,
+ * not via a reference to `Genode::List`.
+ */
+template<typename T>
+class Rtcr::Badge_list : public Genode::List<T>, Genode::Noncopyable
+{
+private:
+
+	enum { MIN_SLOTS = 64 };
+
+	Genode::Allocator &_alloc;
+
+	/**
+	 * Entry of the hash table
+	 *
+	 * Elements with the same badge occupy their own slots. The insertion
+	 * sequence number tells which of them was inserted last.
+	 */
+	struct Slot
+	{
+		T *element;
+		unsigned long seq;
+	};
+
+	/**
+	 * Hash table, whose number of slots is a power of two
+	 */
+	Slot *_slots = nullptr;
+	unsigned _shift = 0;
+	unsigned _used = 0;
+	unsigned _count = 0;
+	unsigned long _seq = 0;
+
+	/**
+	 * Marker of a slot whose element was removed, which must not end a probe
+	 */
+	static T *_removed() { return reinterpret_cast<T*>(1UL); }
+
+	unsigned _num_slots() const { return _slots ? 1U << _shift : 0; }
+
+	/**
+	 * Fibonacci hashing, which spreads consecutive badges over the table
+	 */
+	unsigned _hash(Genode::uint16_t badge) const {
+		return (Genode::uint32_t)(badge * 2654435769U) >> (32 - _shift); }
+
+	void _place(Slot const &entry)
+	{
+		unsigned const mask = _num_slots() - 1;
+		unsigned slot = _hash(entry.element->badge());
+		while(_slots[slot].element && _slots[slot].element != _removed())
+			slot = (slot + 1) & mask;
+		if(!_slots[slot].element)
+			_used++;
+		_slots[slot] = entry;
+		_count++;
+	}
+
+	/**
+	 * Rebuild the table, which drops all removed markers
+	 */
+	void _resize(unsigned min_slots)
+	{
+		unsigned shift = 1;
+		while((1U << shift) < Genode::max(min_slots, (unsigned)MIN_SLOTS))
+			shift++;
+
+		Slot *old_slots = _slots;
+		unsigned const old_num_slots = _num_slots();
+
+		_slots = (Slot*)_alloc.alloc(sizeof(Slot) << shift);
+		_shift = shift;
+		_used = 0;
+		_count = 0;
+		for(unsigned i = 0; i < _num_slots(); i++)
+			_slots[i] = Slot { nullptr, 0 };
+
+		for(unsigned i = 0; i < old_num_slots; i++)
+			if(old_slots[i].element && old_slots[i].element != _removed())
+				_place(old_slots[i]);
+
+		if(old_slots)
+			_alloc.free(old_slots, sizeof(Slot)*old_num_slots);
+	}
+
+public:
+
+	Badge_list(Genode::Allocator &alloc) : _alloc(alloc) { }
+
+	~Badge_list()
+	{
+		if(_slots)
+			_alloc.free(_slots, sizeof(Slot)*_num_slots());
+	}
+
+	/**
+	 * Insert `element` at the head of the list
+	 */
+	void insert(T *element)
+	{
+		/* keep the table at most three quarters full, including removed slots */
+		if(4*(_used + 1) > 3*_num_slots())
+			_resize(4*(_count + 1));
+
+		_place(Slot { element, ++_seq });
+		Genode::List<T>::insert(element);
+	}
+
+	/**
+	 * Remove `element` from the list
+	 */
+	void remove(T *element)
+	{
+		Genode::List<T>::remove(element);
+		if(!_slots)
+			return;
+
+		unsigned const mask = _num_slots() - 1;
+		for(unsigned slot = _hash(element->badge()); _slots[slot].element; slot = (slot + 1) & mask) {
+			if(_slots[slot].element == element) {
+				_slots[slot].element = _removed();
+				_count--;
+				return;
+			}
+		}
+	}
+
+	/**
+	 * \return element with the badge `badge` or nullptr
+	 */
+	T *find_by_badge(Genode::uint16_t badge) const
+	{
+		if(!_slots)
+			return nullptr;
+
+		/* the probe sequence holds all elements with the badge */
+		Slot const *found = nullptr;
+		unsigned const mask = _num_slots() - 1;
+		for(unsigned slot = _hash(badge); _slots[slot].element; slot = (slot + 1) & mask) {
+			Slot const &entry = _slots[slot];
+			if(entry.element != _removed() && entry.element->badge() == badge)
+				if(!found || entry.seq > found->seq)
+					found = &entry;
+		}
+		return found ? found->element : nullptr;
+	}
+};
+
+#endif /* _RTCR_BADGE_LIST_H_ */
@@ -0,0 +1,166 @@
+/*
+ * \brief Dynamically sized bitmap
+ * \author Johannes Fischer
+ * \date 2026-10-16
+ */
+
+#ifndef _RTCR_BITMAP_H_
+#define _RTCR_BITMAP_H_
+
+#include <base/allocator.h>
+#include <util/string.h>
+#include <util/misc_math.h>
+
+namespace Rtcr {
+	class Bitmap;
+}
+
+
+/**
+ * Bitmap with a size defined at runtime, e.g. one bit per page of a dataspace
+ */
+class Rtcr::Bitmap
+{
+private:
+	typedef Genode::addr_t Word;
+	enum { WORD_BITS = sizeof(Word)*8 };
+
+	Genode::Allocator &_alloc;
+	Genode::size_t const _bits;
+	Genode::size_t const _words;
+	Word *_word;
+
+	/* not copyable */
+	Bitmap(Bitmap const &);
+	Bitmap &operator = (Bitmap const &);
+
+	static Word _mask(Genode::size_t bit) { return (Word)1 << (bit % WORD_BITS); }
+
+public:
+	Bitmap(Genode::Allocator &alloc, Genode::size_t bits, bool set = false)
+		:
+		_alloc(alloc),
+		_bits(bits),
+		_words(bits ? (bits + WORD_BITS - 1) / WORD_BITS : 1),
+		_word((Word*)alloc.alloc(_words*sizeof(Word)))
+	{
+		if(set) set_all();
+		else clear_all();
+	}
+
+	~Bitmap() { _alloc.free(_word, _words*sizeof(Word)); }
+
+	Genode::size_t bits() const { return _bits; }
+
+	bool get(Genode::size_t bit) const
+	{
+		return bit < _bits && (_word[bit / WORD_BITS] & _mask(bit));
+	}
+
+	void set(Genode::size_t first, Genode::size_t count = 1)
+	{
+		for(Genode::size_t bit = first; bit < first + count && bit < _bits; bit++)
+			_word[bit / WORD_BITS] |= _mask(bit);
+	}
+
+	void clear(Genode::size_t first, Genode::size_t count = 1)
+	{
+		for(Genode::size_t bit = first; bit < first + count && bit < _bits; bit++)
+			_word[bit / WORD_BITS] &= ~_mask(bit);
+	}
+
+	void clear_all() { Genode::memset(_word, 0, _words*sizeof(Word)); }
+
+	void set_all()
+	{
+		Genode::memset(_word, 0, _words*sizeof(Word));
+		set(0, _bits);
+	}
+
+	/**
+	 * Replace all bits by the bits of `other` and clear `other`
+	 *
+	 * Both bitmaps must have the same size.
+	 */
+	void take(Bitmap &other)
+	{
+		Genode::memcpy(_word, other._word, _words*sizeof(Word));
+		other.clear_all();
+	}
+
+	/**
+	 * Set all bits which are set in `other`
+	 *
+	 * Both bitmaps must have the same size.
+	 */
+	void merge(Bitmap const &other)
+	{
+		for(Genode::size_t i = 0; i < _words; i++)
+			_word[i] |= other._word[i];
+	}
+
+	/**
+	 * Exchange the bits with `other`
+	 *
+	 * Both bitmaps must have the same size.
+	 */
+	void swap(Bitmap &other)
+	{
+		Word *word = _word;
+		_word = other._word;
+		other._word = word;
+	}
+
+	/**
+	 * \return number of set bits
+	 */
+	Genode::size_t count() const
+	{
+		Genode::size_t n = 0;
+		for(Genode::size_t i = 0; i < _words; i++)
+			n += __builtin_popcountl(_word[i]);
+		return n;
+	}
+
+	bool any() const
+	{
+		for(Genode::size_t i = 0; i < _words; i++)
+			if(_word[i]) return true;
+		return false;
+	}
+
+	/**
+	 * Call `fn(first, count)` for each run of consecutive set bits within
+	 * the bits `first` to `first + count - 1`
+	 */
+	template <typename FN>
+	void for_each_run(Genode::size_t first, Genode::size_t count, FN const &fn) const
+	{
+		Genode::size_t const end = Genode::min(first + count, _bits);
+		Genode::size_t bit = first;
+		while(bit < end) {
+			/* skip empty words at once */
+			if(!_word[bit / WORD_BITS] && !(bit % WORD_BITS)) {
+				bit += WORD_BITS;
+				continue;
+			}
+			if(!get(bit)) {
+				bit++;
+				continue;
+			}
+			Genode::size_t const run = bit;
+			while(bit < end && get(bit))
+				bit++;
+			fn(run, bit - run);
+		}
+	}
+
+	/**
+	 * Call `fn(first, count)` for each run of consecutive set bits
+	 */
+	template <typename FN>
+	void for_each_run(FN const &fn) const { for_each_run(0, _bits, fn); }
+};
+
+
+#endif /* _RTCR_BITMAP_H_ */
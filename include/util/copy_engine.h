@@ -0,0 +1,27 @@
+/*
+ * \brief  Bulk copy of checkpointed memory
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_COPY_ENGINE_H_
+#define _RTCR_COPY_ENGINE_H_
+
+#include <base/stdint.h>
+
+namespace Rtcr {
+
+	/**
+	 * Copy memory of a hot dataspace to a cold dataspace
+	 *
+	 * In contrast to `Genode::memcpy`, the destination is written with
+	 * streaming stores if the architecture provides them. The cold copy is not
+	 * read again during a checkpoint, therefore it should not evict the
+	 * working set of the child from the caches.
+	 *
+	 * An implementation exists for each architecture in `src/rtcr/spec/`.
+	 */
+	void copy_memory(void *dst, void const *src, Genode::size_t size);
+}
+
+#endif /* _RTCR_COPY_ENGINE_H_ */
@@ -0,0 +1,121 @@
+/*
+ * \brief Streaming statistics of latencies
+ * \author Johannes Fischer
+ * \date 2026-10-16
+ */
+
+#ifndef _RTCR_LATENCY_HISTOGRAM_H_
+#define _RTCR_LATENCY_HISTOGRAM_H_
+
+#include <base/lock.h>
+#include <util/string.h>
+#include <util/misc_math.h>
+
+namespace Rtcr {
+	class Latency_histogram;
+}
+
+
+/**
+ * Histogram of latencies in microseconds
+ *
+ * All samples are counted in buckets of powers of two, i.e. bucket `i`
+ * counts the latencies below `2^i` microseconds. Minimum, maximum and mean
+ * cover all samples. The percentiles are computed from the last `WINDOW`
+ * samples only, so that they follow changes of the latency.
+ */
+class Rtcr::Latency_histogram
+{
+public:
+
+	enum { BUCKETS = 40, WINDOW = 256 };
+
+	typedef unsigned long long Us;
+
+private:
+
+	mutable Genode::Lock _lock;
+
+	unsigned long _bucket[BUCKETS];
+	unsigned long _count = 0;
+	Us _min = ~0ULL;
+	Us _max = 0;
+	Us _sum = 0;
+
+	/* ring buffer of the last samples */
+	Us _window[WINDOW];
+	unsigned _next = 0;
+
+	static unsigned _bucket_of(Us us)
+	{
+		unsigned bucket = 0;
+		while(bucket < BUCKETS - 1 && us >= (1ULL << bucket))
+			bucket++;
+		return bucket;
+	}
+
+public:
+
+	Latency_histogram() { Genode::memset(_bucket, 0, sizeof(_bucket)); }
+
+	void record(Us us)
+	{
+		Genode::Lock::Guard guard(_lock);
+
+		_bucket[_bucket_of(us)]++;
+		_count++;
+		_min = Genode::min(_min, us);
+		_max = Genode::max(_max, us);
+		_sum += us;
+
+		_window[_next] = us;
+		_next = (_next + 1) % WINDOW;
+	}
+
+	unsigned long count() const { return _count; }
+	Us min() const { return _count ? _min : 0; }
+	Us max() const { return _max; }
+	Us mean() const { return _count ? _sum / _count : 0; }
+
+	/**
+	 * \return latency below which `permille` of the samples in the window
+	 *         are, e.g. 990 for the 99th percentile
+	 */
+	Us percentile(unsigned permille) const
+	{
+		Us sorted[WINDOW];
+		unsigned n;
+		{
+			Genode::Lock::Guard guard(_lock);
+			n = (unsigned)Genode::min(_count, (unsigned long)WINDOW);
+			Genode::memcpy(sorted, _window, n*sizeof(Us));
+		}
+		if(!n) return 0;
+
+		/* insertion sort, the window is small */
+		for(unsigned i = 1; i < n; i++) {
+			Us const value = sorted[i];
+			unsigned j = i;
+			for(; j > 0 && sorted[j - 1] > value; j--)
+				sorted[j] = sorted[j - 1];
+			sorted[j] = value;
+		}
+
+		unsigned const rank = (unsigned)(((unsigned long long)permille*n + 999) / 1000);
+		return sorted[rank ? rank - 1 : 0];
+	}
+
+	/**
+	 * Call `fn(upper_us, count)` for each non-empty bucket, whose samples
+	 * are below `upper_us`
+	 */
+	template <typename FN>
+	void for_each_bucket(FN const &fn) const
+	{
+		Genode::Lock::Guard guard(_lock);
+		for(unsigned i = 0; i < BUCKETS; i++)
+			if(_bucket[i]) fn(1ULL << i, _bucket[i]);
+	}
+};
+
+#endif /* _RTCR_LATENCY_HISTOGRAM_H_ */
@@ -0,0 +1,50 @@
+/*
+ * \brief  Fast compression of cold dataspaces
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#ifndef _RTCR_LZ4_H_
+#define _RTCR_LZ4_H_
+
+#include <base/stdint.h>
+
+namespace Rtcr { namespace Lz4 {
+
+	enum { HASH_LOG = 12 };
+
+	/**
+	 * Positions of recently seen 4-byte sequences
+	 *
+	 * The table is too large for the stack of a checkpointable thread,
+	 * therefore it is provided by the caller.
+	 */
+	struct Hash_table { Genode::uint32_t slot[1 << HASH_LOG]; };
+
+	/**
+	 * \return size of the buffer, which is sufficient for compressing `size`
+	 *         bytes in the worst case
+	 */
+	inline Genode::size_t bound(Genode::size_t size) { return size + size/255 + 16; }
+
+	/**
+	 * Compress memory into the LZ4 block format
+	 *
+	 * \return size of the compressed data or 0, if it does not fit into
+	 *         `capacity` bytes
+	 */
+	Genode::size_t compress(void const *src, Genode::size_t size,
+	                        void *dst, Genode::size_t capacity,
+	                        Hash_table &table);
+
+	/**
+	 * Decompress memory in the LZ4 block format
+	 *
+	 * \return size of the decompressed data or 0, if `src` is malformed or
+	 *         the data does not fit into `capacity` bytes
+	 */
+	Genode::size_t decompress(void const *src, Genode::size_t size,
+	                          void *dst, Genode::size_t capacity);
+} }
+
+#endif /* _RTCR_LZ4_H_ */
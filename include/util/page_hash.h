@@ -0,0 +1,191 @@
+/*
+ * \brief Fingerprints of memory pages
+ * \author Johannes Fischer
+ * \date 2026-10-16
+ */
+
+#ifndef _RTCR_PAGE_HASH_H_
+#define _RTCR_PAGE_HASH_H_
+
+#include <base/allocator.h>
+#include <util/string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace Rtcr {
+	class Fingerprint_table;
+
+	inline Genode::uint64_t page_hash(void const *addr, Genode::size_t size);
+}
+
+
+namespace Rtcr { namespace Page_hash {
+
+	enum : Genode::uint64_t {
+		PRIME_1 = 0x9e3779b185ebca87ULL,
+		PRIME_2 = 0xc2b2ae3d27d4eb4fULL,
+		PRIME_3 = 0x165667b19e3779f9ULL,
+		PRIME_4 = 0x85ebca77c2b2ae63ULL,
+		STEP    = 0x27d4eb2f165667c5ULL,
+	};
+
+	/*
+	 * The memory is processed in stripes of four 64-bit words. Each word is
+	 * mixed with a key, which depends on its lane and on the index of its
+	 * stripe, so that moving data within a page changes the fingerprint. The
+	 * NEON and the scalar implementation compute the same value.
+	 */
+	enum { STRIPE_SIZE = 32 };
+
+	inline Genode::uint64_t avalanche(Genode::uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= PRIME_2;
+		h ^= h >> 29;
+		h *= PRIME_3;
+		h ^= h >> 32;
+		return h;
+	}
+
+	inline Genode::uint64_t accumulate(Genode::uint64_t acc,
+	                                   Genode::uint64_t word,
+	                                   Genode::uint64_t key)
+	{
+		Genode::uint64_t const dk = word ^ key;
+		return acc + (dk & 0xffffffff)*(dk >> 32) + word;
+	}
+
+	inline void stripes_scalar(Genode::uint64_t acc[4],
+	                           Genode::uint64_t const *words,
+	                           Genode::size_t stripes)
+	{
+		Genode::uint64_t key[4] = { PRIME_1, PRIME_2, PRIME_3, PRIME_4 };
+		for(Genode::size_t s = 0; s < stripes; s++, words += 4) {
+			for(unsigned lane = 0; lane < 4; lane++) {
+				acc[lane] = accumulate(acc[lane], words[lane], key[lane]);
+				key[lane] += STEP;
+			}
+		}
+	}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	inline uint64x2_t accumulate(uint64x2_t acc, uint64x2_t word, uint64x2_t key)
+	{
+		uint64x2_t const dk = veorq_u64(word, key);
+		uint64x2_t const product = vmull_u32(vmovn_u64(dk), vshrn_n_u64(dk, 32));
+		return vaddq_u64(acc, vaddq_u64(product, word));
+	}
+
+	inline void stripes_neon(Genode::uint64_t acc[4],
+	                         Genode::uint64_t const *words,
+	                         Genode::size_t stripes)
+	{
+		uint64x2_t acc_lo = vld1q_u64(acc);
+		uint64x2_t acc_hi = vld1q_u64(acc + 2);
+
+		Genode::uint64_t const keys[4] = { PRIME_1, PRIME_2, PRIME_3, PRIME_4 };
+		uint64x2_t key_lo = vld1q_u64(keys);
+		uint64x2_t key_hi = vld1q_u64(keys + 2);
+		uint64x2_t const step = vdupq_n_u64(STEP);
+
+		for(Genode::size_t s = 0; s < stripes; s++, words += 4) {
+			acc_lo = accumulate(acc_lo, vld1q_u64(words), key_lo);
+			acc_hi = accumulate(acc_hi, vld1q_u64(words + 2), key_hi);
+			key_lo = vaddq_u64(key_lo, step);
+			key_hi = vaddq_u64(key_hi, step);
+		}
+
+		vst1q_u64(acc, acc_lo);
+		vst1q_u64(acc + 2, acc_hi);
+	}
+#endif
+} }
+
+
+/**
+ * Compute a 64-bit fingerprint of a memory area
+ *
+ * \param addr  8-byte aligned start of the area
+ * \param size  size of the area in bytes
+ */
+Genode::uint64_t Rtcr::page_hash(void const *addr, Genode::size_t size)
+{
+	using namespace Page_hash;
+
+	Genode::uint64_t acc[4] = { PRIME_1, PRIME_2, PRIME_3, PRIME_4 };
+	Genode::size_t const stripes = size / STRIPE_SIZE;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	stripes_neon(acc, (Genode::uint64_t const*)addr, stripes);
+#else
+	stripes_scalar(acc, (Genode::uint64_t const*)addr, stripes);
+#endif
+
+	/* fold remaining bytes into the first lane */
+	Genode::uint8_t const *tail = (Genode::uint8_t const*)addr + stripes*STRIPE_SIZE;
+	for(Genode::size_t i = 0; i < size % STRIPE_SIZE; i++)
+		acc[0] = (acc[0] ^ tail[i])*PRIME_1;
+
+	Genode::uint64_t h = size*PRIME_4;
+	for(unsigned lane = 0; lane < 4; lane++)
+		h = (h ^ avalanche(acc[lane]))*PRIME_1 + PRIME_4;
+	return avalanche(h);
+}
+
+
+/**
+ * Fingerprints of all pages of a dataspace
+ */
+class Rtcr::Fingerprint_table
+{
+private:
+	Genode::Allocator &_alloc;
+	Genode::size_t const _count;
+	Genode::uint64_t *_hash;
+
+	/* not copyable */
+	Fingerprint_table(Fingerprint_table const &);
+	Fingerprint_table &operator = (Fingerprint_table const &);
+
+public:
+	Fingerprint_table(Genode::Allocator &alloc, Genode::size_t count)
+		:
+		_alloc(alloc),
+		_count(count ? count : 1),
+		_hash((Genode::uint64_t*)alloc.alloc(_count*sizeof(Genode::uint64_t)))
+	{
+		Genode::memset(_hash, 0, _count*sizeof(Genode::uint64_t));
+	}
+
+	~Fingerprint_table() { _alloc.free(_hash, _count*sizeof(Genode::uint64_t)); }
+
+	/**
+	 * True if the fingerprints match the cold dataspace
+	 */
+	bool valid = false;
+
+	Genode::size_t count() const { return _count; }
+
+	Genode::uint64_t &operator [] (Genode::size_t page) { return _hash[page]; }
+
+	/**
+	 * Exchange the fingerprints with `other`
+	 *
+	 * Both tables must have the same size.
+	 */
+	void swap(Fingerprint_table &other)
+	{
+		Genode::uint64_t *hash = _hash;
+		_hash = other._hash;
+		other._hash = hash;
+
+		bool const v = valid;
+		valid = other.valid;
+		other.valid = v;
+	}
+};
+
+
+#endif /* _RTCR_PAGE_HASH_H_ */
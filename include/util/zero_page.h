@@ -0,0 +1,61 @@
+/*
+ * \brief Test for memory pages containing only zeros
+ * \author Johannes Fischer
+ * \date 2026-10-16
+ */
+
+#ifndef _RTCR_ZERO_PAGE_H_
+#define _RTCR_ZERO_PAGE_H_
+
+#include <base/stdint.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace Rtcr {
+	inline bool is_zero(void const *addr, Genode::size_t size);
+}
+
+
+/**
+ * Test if a memory area contains only zeros
+ *
+ * Blocks of 64 bytes are combined by OR and tested at once, which stops the
+ * test shortly after the first non-zero byte.
+ *
+ * \param addr  8-byte aligned start of the area
+ * \param size  size of the area in bytes
+ */
+bool Rtcr::is_zero(void const *addr, Genode::size_t size)
+{
+	enum { BLOCK_SIZE = 64 };
+
+	Genode::size_t const blocks = size / BLOCK_SIZE;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	Genode::uint32_t const *word = (Genode::uint32_t const*)addr;
+	for(Genode::size_t i = 0; i < blocks; i++, word += BLOCK_SIZE / 4) {
+		uint32x4_t const v = vorrq_u32(vorrq_u32(vld1q_u32(word),     vld1q_u32(word + 4)),
+		                               vorrq_u32(vld1q_u32(word + 8), vld1q_u32(word + 12)));
+		uint32x2_t const h = vorr_u32(vget_low_u32(v), vget_high_u32(v));
+		if(vget_lane_u32(vpmax_u32(h, h), 0))
+			return false;
+	}
+#else
+	Genode::uint64_t const *word = (Genode::uint64_t const*)addr;
+	for(Genode::size_t i = 0; i < blocks; i++, word += BLOCK_SIZE / 8) {
+		if(word[0] | word[1] | word[2] | word[3] | word[4] | word[5] | word[6] | word[7])
+			return false;
+	}
+#endif
+
+	Genode::uint8_t const *tail = (Genode::uint8_t const*)addr + blocks*BLOCK_SIZE;
+	for(Genode::size_t i = 0; i < size % BLOCK_SIZE; i++)
+		if(tail[i]) return false;
+
+	return true;
+}
+
+
+#endif /* _RTCR_ZERO_PAGE_H_ */
@@ -1,7 +1,7 @@
-SRC_CC = module_factory.cc base_module.cc init_module.cc checkpointable.cc child_info.cc child.cc
+SRC_CC = module_factory.cc base_module.cc init_module.cc checkpointable.cc checkpoint_pool.cc child_info.cc child.cc checkpoint_scheduler.cc tracer.cc placement.cc
 SRC_CC += cpu_thread.cc
-SRC_CC += pd_session.cc
-SRC_CC += rm_session.cc region_map.cc
+SRC_CC += pd_session.cc copy_engine.cc cold_pool.cc lz4.cc
+SRC_CC += rm_session.cc region_map.cc write_tracker.cc
 SRC_CC += rom_session.cc
 SRC_CC += log_session.cc
 SRC_CC += timer_session.cc
@@ -28,12 +28,16 @@ endif
 
 ifeq ($(filter-out $(SPECS),arm),)
 vpath % $(REP_DIR)/src/rtcr/spec/arm
+CC_OPT_copy_engine += -mfpu=neon
 endif
 
 ifeq ($(filter-out $(SPECS),arm_64),)
 vpath % $(REP_DIR)/src/rtcr/spec/arm_64
 endif
 
+# fallback for architectures without a specific implementation
+vpath % $(REP_DIR)/src/rtcr/spec/generic
+
 
 
 LIBS += base
@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# brief: Run run/rtcr_bench for a range of workload parameters
+# author: Johannes Fischer
+# date: 2026-10-16
+#
+# usage: rtcr_bench_sweep.sh <build-dir> [output.csv]
+#
+# Every combination of the values below is benchmarked. Each measured
+# checkpoint becomes one CSV line consisting of the parameters and the
+# values logged by rtcr_app. The value lists can be overridden by the
+# environment, e.g. `SWEEP_RAM="1M 64M" rtcr_bench_sweep.sh build/x86_64`.
+#
+
+set -e
+
+BUILD_DIR=${1:?usage: $0 <build-dir> [output.csv]}
+OUT=${2:-rtcr_bench.csv}
+
+SWEEP_RAM=${SWEEP_RAM:-"1M 8M 32M"}
+SWEEP_DIRTY_RATE=${SWEEP_DIRTY_RATE:-"100 1000 10000"}
+SWEEP_PATTERN=${SWEEP_PATTERN:-"sequential random hotspot"}
+SWEEP_THREADS=${SWEEP_THREADS:-"1 4"}
+SWEEP_COPY=${SWEEP_COPY:-"full incremental"}
+
+# some scripts of Genode expect an english environment
+export LANG=en_US.UTF-8
+
+echo "ram,dirty_rate,pattern,threads,copy,checkpoint_nr,pause_us,checkpoint_us,serialize_us,serialized_bytes,copied_bytes,mib_per_s" > "$OUT"
+
+for ram in $SWEEP_RAM; do
+for dirty_rate in $SWEEP_DIRTY_RATE; do
+for pattern in $SWEEP_PATTERN; do
+for threads in $SWEEP_THREADS; do
+for copy in $SWEEP_COPY; do
+	log=$(RTCR_BENCH_RAM=$ram \
+	      RTCR_BENCH_DIRTY_RATE=$dirty_rate \
+	      RTCR_BENCH_PATTERN=$pattern \
+	      RTCR_BENCH_THREADS=$threads \
+	      RTCR_BENCH_CHECKPOINT="copy=\"$copy\"" \
+	      make -C "$BUILD_DIR" run/rtcr_bench 2>&1) || {
+		echo "failed: ram=$ram dirty_rate=$dirty_rate pattern=$pattern threads=$threads copy=$copy" >&2
+		continue
+	}
+
+	# turn "[bench] key=value ..." into the values of a CSV line
+	echo "$log" | grep -o '\[bench\].*' | tr -d '\r' | while read -r line; do
+		values=$(echo "$line" | grep -o '[a-z_]*=[0-9]*' | cut -d= -f2 | paste -sd,)
+		echo "$ram,$dirty_rate,$pattern,$threads,$copy,$values"
+	done >> "$OUT"
+done
+done
+done
+done
+done
+
+echo "results written to $OUT"
@@ -30,6 +30,8 @@
 #include <rtcr/child.h>
 #include <rtcr/module_factory.h>
 #include <rtcr/base_module.h>
+#include <rtcr/checkpoint_scheduler.h>
+#include <rtcr/tracer.h>
 #include <rtcr_serializer/serializer.h>
 
 #include <pd_session/pd_session.h>
@@ -61,6 +63,52 @@ struct Rtcr::Main
 	                               Genode::Rom_session,
 	                               Genode::Log_session> parent_services { env };
 
+	/**
+	 * Checkpoint and serialize the childs repeatedly and log the results
+	 * in a machine-readable form
+	 *
+	 * Example configuration:
+	 *
+	 * ```XML
+	 * <benchmark checkpoints="10" interval_ms="200"/>
+	 * ```
+	 */
+	void benchmark(Init_module &module, Serializer &serializer,
+	               Genode::Xml_node bench_node)
+	{
+		unsigned const checkpoints = bench_node.attribute_value("checkpoints", 10U);
+		unsigned long const interval_ms = bench_node.attribute_value("interval_ms", 200UL);
+
+		for(unsigned i = 0; i < checkpoints; i++) {
+			timer.msleep(interval_ms);
+			module.checkpoint();
+
+			Genode::uint64_t const start = timer.elapsed_us();
+			Genode::size_t size = 0;
+			Genode::Ram_dataspace_capability ds_cap;
+			module.with_checkpoint([&] (Genode::List<Child_info> &childs) {
+				Tracer::Scope trace("serialize");
+				ds_cap = serializer.serialize(&childs, &size); });
+			Genode::uint64_t const serialize_us = timer.elapsed_us() - start;
+			env.ram().free(ds_cap);
+
+			Genode::size_t copied_bytes = 0;
+			for(Child_info *child = module.child_info()->first(); child; child = child->next())
+				copied_bytes += static_cast<Pd_session*>(child->pd_session)->copied_pages()
+				                * Ram_dataspace::PAGE_SIZE;
+
+			unsigned long long const checkpoint_us = Genode::max(module.checkpoint_time(), 1ULL);
+			Genode::log("[bench] checkpoint=", i,
+			            " pause_us=", module.pause_time(),
+			            " checkpoint_us=", module.checkpoint_time(),
+			            " serialize_us=", serialize_us,
+			            " serialized_bytes=", size,
+			            " copied_bytes=", copied_bytes,
+			            " mib_per_s=", copied_bytes*1000000ULL / checkpoint_us / (1024*1024));
+		}
+		Genode::log("benchmark completed");
+	}
+
 	Main(Genode::Env &env_) : env(env_)
 	{
 		/* load module based on the configured module name */
@@ -72,8 +120,24 @@ struct Rtcr::Main
 		/* create serializer */
 		Serializer serializer(env, heap);
 
-		/* create a single child */
-		Child sheep (env, heap, "sheep_counter", parent_services, module);
+		/* create a single child, the first configured one */
+		Child_name child_name("sheep_counter");
+		try {
+			child_name = config.xml().sub_node("child").attribute_value("name", child_name);
+		} catch(...) { }
+		Child sheep (env, heap, child_name.string(), parent_services, module);
+
+		/* Checkpoint the childs periodically, if a scheduler is configured */
+		if(config.xml().has_sub_node("scheduler")) {
+			Checkpoint_scheduler scheduler(env, heap, module);
+			Genode::sleep_forever();
+		}
+
+		/* Measure checkpoints, if a benchmark is configured */
+		if(config.xml().has_sub_node("benchmark")) {
+			benchmark(module, serializer, config.xml().sub_node("benchmark"));
+			Genode::sleep_forever();
+		}
 
 		/* Checkpoint all childs */
 		Genode::log("before sleep");
@@ -85,14 +149,17 @@ struct Rtcr::Main
 
 		/* Print all information of the *_info objects. These represents the
 		 * last checkpoint state */
-		Child_info *sheep_info = module.child_info("sheep_counter");
+		Child_info *sheep_info = module.child_info(child_name.string());
 		Genode::log("Child_info before serializing:");
 		Genode::log(*sheep_info);
 
 		// /* Serialize the last checkpoint state */
 		Genode::size_t size;
 		Genode::List<Child_info> *child_infos = module.child_info();
-		Genode::Dataspace_capability ds_cap = serializer.serialize(child_infos, &size);
+		Genode::Dataspace_capability ds_cap;
+		module.with_checkpoint([&] (Genode::List<Child_info> &childs) {
+			Tracer::Scope trace("serialize");
+			ds_cap = serializer.serialize(&childs, &size); });
 		Genode::log("Serialized Size: ", size);
 	  
 		/* Parse serialized dataspace*/
@@ -0,0 +1,117 @@
+/*
+ * \brief  Microbenchmark of the copy engine
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ *
+ * Compares `Rtcr::copy_memory` with `Genode::memcpy` for several dataspace
+ * sizes. Besides the copy throughput, the time for reading a working set
+ * after each copy is measured. It shows how much of the working set was
+ * evicted from the caches by the copy.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/log.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+/* Rtcr includes */
+#include <util/copy_engine.h>
+
+Genode::size_t Component::stack_size() { return 16*1024; }
+
+namespace Rtcr {
+	struct Copy_bench;
+}
+
+
+struct Rtcr::Copy_bench
+{
+	enum {
+		MAX_SIZE         = 16*1024*1024,
+		WORKING_SET      = 256*1024,
+		BYTES_PER_SIZE   = 256*1024*1024,
+		WORKING_SET_RUNS = 16,
+	};
+
+	Genode::Env &_env;
+	Timer::Connection _timer { _env };
+
+	Genode::Attached_ram_dataspace _src { _env.ram(), _env.rm(), MAX_SIZE };
+	Genode::Attached_ram_dataspace _dst { _env.ram(), _env.rm(), MAX_SIZE };
+	Genode::Attached_ram_dataspace _ws  { _env.ram(), _env.rm(), WORKING_SET };
+
+	struct Result
+	{
+		Genode::uint64_t mib_per_s;
+		Genode::uint64_t working_set_us;
+	};
+
+	/**
+	 * Read the working set and return the elapsed time in microseconds
+	 */
+	Genode::uint64_t _read_working_set()
+	{
+		Genode::addr_t const *word = _ws.local_addr<Genode::addr_t>();
+		Genode::uint64_t const start = _timer.elapsed_us();
+
+		Genode::addr_t sum = 0;
+		for(Genode::size_t i = 0; i < WORKING_SET / sizeof(Genode::addr_t); i++)
+			sum += word[i];
+		*(volatile Genode::addr_t*)_ws.local_addr<char>() = sum;
+
+		return _timer.elapsed_us() - start;
+	}
+
+	template <typename FN>
+	Result _measure(Genode::size_t size, FN const &copy)
+	{
+		Result result { 0, 0 };
+
+		Genode::size_t const rounds = Genode::max(BYTES_PER_SIZE / size, (Genode::size_t)1);
+		Genode::uint64_t const start = _timer.elapsed_us();
+		for(Genode::size_t i = 0; i < rounds; i++)
+			copy(_dst.local_addr<void>(), _src.local_addr<void>(), size);
+		Genode::uint64_t const duration = Genode::max(_timer.elapsed_us() - start, (Genode::uint64_t)1);
+		result.mib_per_s = (Genode::uint64_t)rounds*size / duration * 1000000 / (1024*1024);
+
+		for(unsigned i = 0; i < WORKING_SET_RUNS; i++) {
+			_read_working_set();
+			copy(_dst.local_addr<void>(), _src.local_addr<void>(), size);
+			result.working_set_us += _read_working_set();
+		}
+		result.working_set_us /= WORKING_SET_RUNS;
+
+		return result;
+	}
+
+	Copy_bench(Genode::Env &env) : _env(env)
+	{
+		Genode::memset(_src.local_addr<void>(), 0x55, MAX_SIZE);
+		Genode::memset(_ws.local_addr<void>(), 0xaa, WORKING_SET);
+
+		Genode::log("working set: ", WORKING_SET / 1024, " KiB");
+
+		for(Genode::size_t size = 4096; size <= MAX_SIZE; size *= 4) {
+			Result const plain = _measure(size, [] (void *dst, void const *src, Genode::size_t n) {
+				Genode::memcpy(dst, src, n); });
+			Result const engine = _measure(size, [] (void *dst, void const *src, Genode::size_t n) {
+				copy_memory(dst, src, n); });
+
+			Genode::log("size ", size / 1024, " KiB: ",
+			            "memcpy ", plain.mib_per_s, " MiB/s, ",
+			            "working set ", plain.working_set_us, " us | ",
+			            "copy_memory ", engine.mib_per_s, " MiB/s, ",
+			            "working set ", engine.working_set_us, " us");
+		}
+
+		Genode::log("benchmark completed");
+	}
+};
+
+
+void Component::construct(Genode::Env &env)
+{
+	static Rtcr::Copy_bench bench(env);
+}
@@ -0,0 +1,3 @@
+TARGET = rtcr_copy_bench
+SRC_CC = main.cc
+LIBS   = base rtcr
@@ -0,0 +1,258 @@
+/*
+ * \brief  Configurable workload for benchmarking checkpoints
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ *
+ * This program is a target for the rtcr service like `sheep_counter`, but
+ * its state is configurable. It allocates Ram dataspaces, region maps,
+ * signal contexts and RPC capabilities, and writes pages of its Ram with a
+ * configured rate and pattern from a number of threads. The parameters are
+ * read from the ROM module `rtcr_workload.config`:
+ *
+ * ```XML
+ * <workload ram="8M" dataspaces="4" region_maps="2" dirty_rate="2000"
+ *           pattern="hotspot" threads="2" signal_contexts="16" rpc_caps="8"/>
+ * ```
+ *
+ * The pattern is `sequential`, `random` or `hotspot`, where 90 percent of the
+ * writes hit the first 10 percent of the pages.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/attached_rom_dataspace.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <base/rpc_server.h>
+#include <base/signal.h>
+#include <base/thread.h>
+#include <rm_session/connection.h>
+#include <region_map/client.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+Genode::size_t Component::stack_size() { return 16*1024; }
+
+namespace Rtcr {
+	struct Workload;
+}
+
+
+struct Rtcr::Workload
+{
+	enum { PAGE_SIZE = 4096, MAX_REGIONS = 64, MAX_THREADS = 32 };
+	enum Pattern { SEQUENTIAL, RANDOM, HOTSPOT };
+
+	/**
+	 * Interface of the RPC objects, which only exist for their capabilities
+	 */
+	struct Idle : Genode::Interface
+	{
+		virtual void ping() = 0;
+
+		GENODE_RPC(Rpc_ping, void, ping);
+		GENODE_RPC_INTERFACE(Rpc_ping);
+	};
+
+	struct Idle_object : Genode::Rpc_object<Idle>
+	{
+		void ping() override { }
+	};
+
+	/**
+	 * Pages of the workload, possibly attached via a region map
+	 */
+	struct Region
+	{
+		Genode::uint8_t *base;
+		Genode::size_t pages;
+	};
+
+	/**
+	 * Thread writing pages of all regions
+	 */
+	struct Dirtier : Genode::Thread
+	{
+		Workload &_workload;
+		unsigned const _index;
+
+		Dirtier(Genode::Env &env, Workload &workload, unsigned index)
+			:
+			Genode::Thread(env, Genode::String<32>("dirtier_", index).string(), 16*1024),
+			_workload(workload), _index(index) { }
+
+		void entry() override { _workload._dirty(_index); }
+	};
+
+	Genode::Env &_env;
+	Genode::Heap _heap { _env.ram(), _env.rm() };
+	Genode::Attached_rom_dataspace _config { _env, "rtcr_workload.config" };
+
+	Genode::size_t const _ram;
+	unsigned const _dataspaces;
+	unsigned const _region_maps;
+	unsigned long const _dirty_rate;
+	Pattern const _pattern;
+	unsigned const _threads;
+	unsigned const _signal_contexts;
+	unsigned const _rpc_caps;
+
+	Region _regions[MAX_REGIONS];
+	unsigned _num_regions = 0;
+	Genode::size_t _num_pages = 0;
+
+	Genode::Signal_receiver _receiver { };
+
+	/* iterations of the busy loop per millisecond */
+	unsigned long _loops_per_ms = 0;
+
+	template <typename T>
+	T _read(char const *attr, T default_value)
+	{
+		return _config.xml().attribute_value(attr, default_value);
+	}
+
+	Pattern _read_pattern()
+	{
+		typedef Genode::String<16> Name;
+		Name const pattern = _read("pattern", Name("sequential"));
+		if(pattern == "random")  return RANDOM;
+		if(pattern == "hotspot") return HOTSPOT;
+		return SEQUENTIAL;
+	}
+
+	/**
+	 * Allocate the Ram, the first dataspaces are attached via own region maps
+	 */
+	void _alloc_ram()
+	{
+		unsigned const count = Genode::min(Genode::max(_dataspaces, 1U), (unsigned)MAX_REGIONS);
+		Genode::size_t const size = Genode::align_addr(Genode::max(_ram / count, (Genode::size_t)PAGE_SIZE), 12);
+
+		for(unsigned i = 0; i < count; i++) {
+			Genode::Ram_dataspace_capability ds_cap = _env.ram().alloc(size);
+			void *base;
+			if(i < _region_maps) {
+				Genode::Rm_connection *rm = new (_heap) Genode::Rm_connection(_env);
+				Genode::Region_map_client *region_map =
+					new (_heap) Genode::Region_map_client(rm->create(size));
+				region_map->attach(ds_cap);
+				base = _env.rm().attach(region_map->dataspace());
+			} else {
+				base = _env.rm().attach(ds_cap);
+			}
+
+			_regions[_num_regions++] = { (Genode::uint8_t*)base, size / PAGE_SIZE };
+			_num_pages += size / PAGE_SIZE;
+			Genode::memset(base, 0, size);
+		}
+	}
+
+	void _alloc_capabilities()
+	{
+		for(unsigned i = 0; i < _signal_contexts; i++)
+			_receiver.manage(new (_heap) Genode::Signal_context());
+
+		for(unsigned i = 0; i < _rpc_caps; i++)
+			_env.ep().manage(*new (_heap) Idle_object());
+	}
+
+	/**
+	 * Busy waiting is used like in `sheep_counter` to avoid pausing this
+	 * component during an RPC call to the timer component
+	 */
+	void _spin(unsigned long loops)
+	{
+		for(unsigned long i = 0; i < loops; i++)
+			__asm__("NOP");
+	}
+
+	void _calibrate()
+	{
+		Timer::Connection timer(_env);
+		enum { LOOPS = 10000000 };
+		Genode::uint64_t const start = timer.elapsed_us();
+		_spin(LOOPS);
+		Genode::uint64_t const duration = Genode::max(timer.elapsed_us() - start, (Genode::uint64_t)1);
+		_loops_per_ms = Genode::max((unsigned long)(LOOPS*1000ULL / duration), 1UL);
+	}
+
+	Genode::uint8_t *_page(Genode::size_t page)
+	{
+		for(unsigned i = 0; i < _num_regions; i++) {
+			if(page < _regions[i].pages)
+				return _regions[i].base + page*PAGE_SIZE;
+			page -= _regions[i].pages;
+		}
+		return _regions[0].base;
+	}
+
+	Genode::size_t _next_page(Genode::size_t &cursor, Genode::uint64_t &seed)
+	{
+		seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+		Genode::size_t const r = (Genode::size_t)(seed >> 33);
+
+		switch(_pattern) {
+		case RANDOM:
+			return r % _num_pages;
+		case HOTSPOT: {
+			Genode::size_t const hot = Genode::max(_num_pages / 10, (Genode::size_t)1);
+			return (r % 10) ? r % hot : r % _num_pages;
+		}
+		case SEQUENTIAL:
+			break;
+		}
+		cursor = (cursor + 1) % _num_pages;
+		return cursor;
+	}
+
+	/**
+	 * Write `_dirty_rate` pages per second, shared by all threads
+	 */
+	void _dirty(unsigned index)
+	{
+		unsigned long const rate = _dirty_rate / _threads + (index < _dirty_rate % _threads);
+
+		Genode::size_t cursor = index*_num_pages / _threads;
+		Genode::uint64_t seed = index + 1;
+		unsigned long millipages = 0;
+		for(Genode::uint32_t value = 1;; value++) {
+			/* pages to write within one millisecond */
+			millipages += rate;
+			for(; millipages >= 1000; millipages -= 1000)
+				*(volatile Genode::uint32_t*)_page(_next_page(cursor, seed)) = value;
+
+			_spin(_loops_per_ms);
+		}
+	}
+
+	Workload(Genode::Env &env)
+	:
+		_env(env),
+		_ram(_read("ram", Genode::Number_of_bytes(1024*1024))),
+		_dataspaces(_read("dataspaces", 1U)),
+		_region_maps(_read("region_maps", 0U)),
+		_dirty_rate(_read("dirty_rate", 1000UL)),
+		_pattern(_read_pattern()),
+		_threads(Genode::min(Genode::max(_read("threads", 1U), 1U), (unsigned)MAX_THREADS)),
+		_signal_contexts(_read("signal_contexts", 0U)),
+		_rpc_caps(_read("rpc_caps", 0U))
+	{
+		_alloc_ram();
+		_alloc_capabilities();
+		_calibrate();
+
+		Genode::log("workload: ram=", _num_pages*PAGE_SIZE, " dirty_rate=", _dirty_rate,
+		            " threads=", _threads, " signal_contexts=", _signal_contexts,
+		            " rpc_caps=", _rpc_caps, " region_maps=", _region_maps);
+
+		for(unsigned i = 0; i < _threads; i++)
+			(new (_heap) Dirtier(env, *this, i))->start();
+	}
+};
+
+
+void Component::construct(Genode::Env &env)
+{
+	static Rtcr::Workload workload(env);
+}
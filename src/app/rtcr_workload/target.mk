@@ -0,0 +1,3 @@
+TARGET = rtcr_workload
+SRC_CC = main.cc
+LIBS   = base
@@ -0,0 +1,129 @@
+/*
+ * \brief  Shared worker threads for checkpointing
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#include <rtcr/checkpoint_pool.h>
+
+#ifdef PROFILE
+#include <util/profiler.h>
+#define PROFILE_THIS_CALL PROFILE_FUNCTION("olive");
+#else
+#define PROFILE_THIS_CALL
+#endif
+
+#if DEBUG
+#define DEBUG_THIS_CALL Genode::log("\e[38;5;142m", __PRETTY_FUNCTION__, "\033[0m");
+#else
+#define DEBUG_THIS_CALL
+#endif
+
+using namespace Rtcr;
+
+
+Checkpoint_pool::Worker::Worker(Genode::Env &env, Checkpoint_pool &pool,
+                                unsigned index, Genode::Affinity::Location location)
+	:
+	Genode::Thread(env,
+	               Genode::String<32>("checkpoint_worker_", index).string(),
+	               64*1024,
+	               location,
+	               Genode::Thread::Weight(),
+	               env.cpu()),
+	_pool(pool),
+	_index(index),
+	_location(location)
+{ }
+
+
+Checkpoint_pool::Task *Checkpoint_pool::Worker::take()
+{
+	Genode::Lock::Guard guard(_lock);
+	return _tasks.dequeue();
+}
+
+
+void Checkpoint_pool::Worker::entry()
+{
+	while(true) {
+		_pool._pending.down();
+
+		/* prefer the own queue, steal from the other queues otherwise */
+		Task *task = nullptr;
+		for(unsigned i = 0; !task && i < _pool._count; i++)
+			task = _pool._workers[(_index + i) % _pool._count]->take();
+
+		if(task) task->run();
+	}
+}
+
+
+Checkpoint_pool::Checkpoint_pool(Genode::Env &env, Genode::Xml_node config)
+{
+	config.for_each_sub_node("core", [&] (Genode::Xml_node core) {
+		if(_count == MAX_WORKERS) {
+			Genode::warning("Checkpoint pool is limited to ", (unsigned)MAX_WORKERS, " workers");
+			return;
+		}
+		long const xpos = core.attribute_value<long>("xpos", 0);
+		long const ypos = core.attribute_value<long>("ypos", 0);
+		_workers[_count].construct(env, *this, _count,
+		                           Genode::Affinity::Location(xpos, ypos, 1, 1));
+		_count++;
+	});
+
+	/* at least one worker executes the tasks */
+	if(!_count) {
+		_workers[0].construct(env, *this, 0, Genode::Affinity::Location(0, 0, 1, 1));
+		_count = 1;
+	}
+
+	for(unsigned i = 0; i < _count; i++)
+		_workers[i]->start();
+
+#ifdef VERBOSE
+	Genode::log("Checkpoint pool started with ", _count, " workers");
+#endif
+}
+
+
+unsigned Checkpoint_pool::worker(Genode::Affinity::Location location) const
+{
+	for(unsigned i = 0; i < _count; i++) {
+		Genode::Affinity::Location const l = _workers[i]->_location;
+		if(l.xpos() == location.xpos() && l.ypos() == location.ypos())
+			return i;
+	}
+	return _count;
+}
+
+
+unsigned Checkpoint_pool::submit(Task &task, unsigned preferred)
+{
+	DEBUG_THIS_CALL;
+
+	if(preferred >= _count) {
+		Genode::Lock::Guard guard(_next_lock);
+		preferred = _next;
+		_next = (_next + 1) % _count;
+	}
+
+	{
+		Genode::Lock::Guard guard(_workers[preferred]->_lock);
+		_workers[preferred]->_tasks.enqueue(task);
+	}
+	_pending.up();
+	return preferred;
+}
+
+
+bool Checkpoint_pool::withdraw(Task &task, unsigned queue)
+{
+	Genode::Lock::Guard guard(_workers[queue]->_lock);
+	if(!task.enqueued())
+		return false;
+
+	_workers[queue]->_tasks.remove(task);
+	return true;
+}
@@ -0,0 +1,196 @@
+/*
+ * \brief  Periodic and adaptive triggering of checkpoints
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#include <rtcr/checkpoint_scheduler.h>
+
+#ifdef PROFILE
+#include <util/profiler.h>
+#define PROFILE_THIS_CALL PROFILE_FUNCTION("teal");
+#else
+#define PROFILE_THIS_CALL
+#endif
+
+#if DEBUG
+#define DEBUG_THIS_CALL Genode::log("\e[38;5;30m", __PRETTY_FUNCTION__, "\033[0m");
+#else
+#define DEBUG_THIS_CALL
+#endif
+
+using namespace Rtcr;
+
+
+Checkpoint_scheduler::Checkpoint_scheduler(Genode::Env &env,
+                                           Genode::Allocator &alloc,
+                                           Init_module &module)
+	:
+	_alloc(alloc),
+	_module(module),
+	_config(env, "config"),
+	_period_us(_read("period_us", 1000000UL)),
+	_min_period_us(_read("min_period_us", 1000UL)),
+	_poll_us(_read_poll_us()),
+	_adaptive(_read("adaptive", false)),
+	_max_loss_pages(_read("max_loss_pages", 0UL)),
+	_overhead(_read("overhead", 10U)),
+	_ep(env, 16*1024, "rtcr_scheduler", Genode::Affinity::Location()),
+	_timer(env),
+	_timeout_handler(_ep, *this, &Checkpoint_scheduler::_handle_timeout)
+{
+	DEBUG_THIS_CALL;
+
+	_timer.sigh(_timeout_handler);
+	_arm(_timer.elapsed_us());
+
+#ifdef VERBOSE
+	Genode::log("Checkpoint scheduler: period=", _period_us, "us",
+	            " adaptive=", _adaptive);
+#endif
+}
+
+
+Checkpoint_scheduler::~Checkpoint_scheduler()
+{
+	Genode::Lock::Guard guard(_lock);
+	while(Schedule *schedule = _schedules.first()) {
+		_schedules.remove(schedule);
+		Genode::destroy(_alloc, schedule);
+	}
+}
+
+
+Genode::uint64_t Checkpoint_scheduler::_read_poll_us()
+{
+	Genode::uint64_t poll_us = _period_us;
+	try {
+		_config.xml().sub_node("scheduler").for_each_sub_node("child", [&] (Genode::Xml_node child_node) {
+			poll_us = Genode::min(poll_us, (Genode::uint64_t)
+			                      child_node.attribute_value("period_us", (unsigned long)_period_us)); });
+	} catch(...) { }
+	return Genode::max(poll_us, _min_period_us);
+}
+
+
+bool Checkpoint_scheduler::Due::selected(Child_info const &child) const
+{
+	return _scheduler._schedule(child, true).next_us <= _now_us;
+}
+
+
+Genode::uint64_t Checkpoint_scheduler::_child_period_us(Child_name const &name)
+{
+	/* a child without `child` node is checkpointed with the default period */
+	Genode::uint64_t period_us = _period_us;
+	try {
+		Genode::Xml_node child_node = _config.xml().sub_node("scheduler").sub_node("child");
+		while(child_node.attribute_value("name", Child_name()) != name)
+			child_node = child_node.next("child");
+		period_us = child_node.attribute_value("period_us", (unsigned long)_period_us);
+	} catch(...) { }
+	return period_us;
+}
+
+
+Checkpoint_scheduler::Schedule &Checkpoint_scheduler::_schedule(Child_info const &child, bool due)
+{
+	for(Schedule *schedule = _schedules.first(); schedule; schedule = schedule->next())
+		if(schedule->name == child.name)
+			return *schedule;
+
+	Schedule *schedule = new (_alloc) Schedule(child.name, _child_period_us(child.name),
+	                                           _timer.elapsed_us());
+	if(due)
+		schedule->next_us = schedule->last_us;
+	_schedules.insert(schedule);
+	return *schedule;
+}
+
+
+void Checkpoint_scheduler::_adapt(Schedule &schedule, Child_info &child,
+                                  Genode::uint64_t now_us, Genode::uint64_t cost_us)
+{
+	Genode::uint64_t const elapsed_us = now_us - schedule.last_us;
+	schedule.last_us = now_us;
+
+	if(!_adaptive || !elapsed_us)
+		return;
+
+	/* copied pages per second, the first sample is taken as is. In the full
+	 * copy mode, all copied pages are assumed to be changed. */
+	Pd_session &pd_session = *static_cast<Pd_session*>(child.pd_session);
+	Genode::uint64_t const rate = pd_session.copied_pages()*1000000ULL / elapsed_us;
+	schedule.dirty_rate = schedule.dirty_rate ? (3*schedule.dirty_rate + rate) / 4 : rate;
+
+	/* bound the pages lost by a failure */
+	Genode::uint64_t interval_us = schedule.period_us;
+	if(_max_loss_pages && schedule.dirty_rate)
+		interval_us = Genode::min<Genode::uint64_t>(interval_us,
+		                          _max_loss_pages*1000000ULL / schedule.dirty_rate);
+	interval_us = Genode::max<Genode::uint64_t>(interval_us, _min_period_us);
+
+	/* bound the time spent on checkpointing */
+	if(_overhead)
+		interval_us = Genode::max<Genode::uint64_t>(interval_us, cost_us*100 / _overhead);
+
+	schedule.interval_us = interval_us;
+}
+
+
+void Checkpoint_scheduler::_handle_timeout()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	Genode::Lock::Guard guard(_lock);
+
+	Genode::uint64_t const now_us = _timer.elapsed_us();
+	Due const due(*this, now_us);
+
+	bool any_due = false;
+	Genode::List<Child_info> &childs = *_module.child_info();
+	for(Child_info *child = childs.first(); child; child = child->next())
+		any_due |= due.selected(*child);
+
+	if(any_due) {
+		_module.checkpoint(due);
+
+		Genode::uint64_t const end_us = _timer.elapsed_us();
+		for(Child_info *child = childs.first(); child; child = child->next()) {
+			if(!due.selected(*child))
+				continue;
+
+			Schedule &schedule = _schedule(*child, true);
+			_adapt(schedule, *child, end_us, _module.checkpoint_time());
+			schedule.next_us = end_us + schedule.interval_us;
+		}
+	}
+
+	_arm(_timer.elapsed_us());
+}
+
+
+void Checkpoint_scheduler::_arm(Genode::uint64_t now_us)
+{
+	/* the first checkpoint of a known child follows after its period */
+	Genode::List<Child_info> &childs = *_module.child_info();
+	for(Child_info *child = childs.first(); child; child = child->next())
+		_schedule(*child, false);
+
+	Genode::uint64_t next_us = now_us + _poll_us;
+	for(Schedule *schedule = _schedules.first(); schedule; schedule = schedule->next())
+		next_us = Genode::min(next_us, schedule->next_us);
+
+	/* childs created since the last timeout are due on the next one */
+	_timer.trigger_once(next_us > now_us ? next_us - now_us : 1);
+}
+
+
+Genode::uint64_t Checkpoint_scheduler::interval_us(char const *name)
+{
+	Genode::Lock::Guard guard(_lock);
+	for(Schedule *schedule = _schedules.first(); schedule; schedule = schedule->next())
+		if(schedule->name == name)
+			return schedule->interval_us;
+	return 0;
+}
@@ -5,34 +5,65 @@
  */
 
 #include <rtcr/checkpointable.h>
+#include <rtcr/tracer.h>
 
 using namespace Rtcr;
 
 Checkpointable::Checkpointable(Genode::Env &env, const char* name, bool ready)
 	:
+	_name(name),
 	_timer(env),
-	_affinity(_read_affinity(name)),
 	_config(env, "config"),
-	Thread(env,
-	       name,
-	       64*1024,
-	       _affinity,
-	       Genode::Thread::Weight(),
-	       env.cpu()),
+	_affinity(_read_affinity(env, name)),
+	_pool(_read_pool(env)),
 	_running(true),
 	_next_job(NONE),
 	_ready_event(ready) // not ready by default
 {
-	Thread::start();
+	if(_pool) {
+		_worker = _pool->worker(_affinity);
+	} else {
+		_thread.construct(env, name, _affinity, *this);
+		_thread->start();
+	}
 
 #ifdef VERBOSE
 	Genode::log("Checkpointable[",name,"] started on CPU ",
-	            "xpos=",_affinity.xpos(), " ypos=",_affinity.ypos());
+	            "xpos=",_affinity.xpos(), " ypos=",_affinity.ypos(),
+	            _pool ? " (pool)" : "");
 #endif
 }
 
 
-Genode::Affinity::Location Checkpointable::_read_affinity(const char* name)
+Checkpoint_pool *Checkpointable::_read_pool(Genode::Env &env)
+{
+	try {
+		Genode::Xml_node pool_node = _config.xml().sub_node("checkpoint_pool");
+
+		/* the pool is shared by the checkpointables of all childs */
+		static Checkpoint_pool pool(env, pool_node);
+		return &pool;
+	}
+	catch (...) { return nullptr; }
+}
+
+
+Placement *Checkpointable::_read_placement(Genode::Env &env)
+{
+	try {
+		Genode::Xml_node placement_node = _config.xml().sub_node("placement");
+		if(placement_node.attribute_value("mode", Genode::String<8>()) != "auto")
+			return nullptr;
+
+		/* the load of the cores is shared by the checkpointables of all childs */
+		static Placement placement(env);
+		return &placement;
+	}
+	catch (...) { return nullptr; }
+}
+
+
+Genode::Affinity::Location Checkpointable::_read_affinity(Genode::Env &env, const char* name)
 {
 	try {
 		Genode::Xml_node config_node = _config.xml();
@@ -45,7 +76,11 @@ Genode::Affinity::Location Checkpointable::_read_affinity(const char* name)
 		long const ypos = ck_node.attribute_value<long>("ypos", 0);
 		return Genode::Affinity::Location(xpos, ypos, 1 ,1);
 	}
-	catch (...) { return Genode::Affinity::Location(0, 0, 1, 1);}
+	catch (...) { }
+
+	/* no explicit affinity */
+	if(Placement *placement = _read_placement(env))
+		return placement->place(name);
 	return Genode::Affinity::Location(0, 0, 1, 1);
 }
 
@@ -54,11 +89,12 @@ void Checkpointable::stop()
 {
 	_running=false;
 	// TODO: not sure if this works, if not than use _next_event.release()
-	cancel_blocking();
+	if(_thread.constructed())
+		_thread->cancel_blocking();
 }
 
 
-void Checkpointable::entry()
+void Checkpointable::_serve()
 {
 	while(_running) {
 		/* wait for the next job */
@@ -68,25 +104,37 @@ void Checkpointable::entry()
 		if(!_running)
 			return;
 
-		/* start next job */
-		Job _current_job = _next_job;
-		_next_job = NONE;
-		if(CHECKPOINT == _current_job) {
-			/* now busy */
-			_ready_event.unset();
+		_execute();
+	}
+}
 
-			/* do checkpoint */
-			unsigned long long start = _timer.elapsed_us();
+
+void Checkpointable::_execute()
+{
+	/* start next job */
+	Job _current_job = _next_job;
+	_next_job = NONE;
+	if(CHECKPOINT == _current_job) {
+		/* now busy */
+		_ready_event.unset();
+
+		/* do checkpoint */
+		unsigned long long start = _timer.elapsed_us();
+		{
+			Tracer::Scope trace(_name.string());
 			checkpoint();
-			_checkpoint_time =  _timer.elapsed_us() - start;
-			_checkpoint_finished.set();
+		}
+		_checkpoint_time =  _timer.elapsed_us() - start;
+		_latency.record(_checkpoint_time);
+		_checkpoint_finished.set();
+		if(_finished_signal)
+			_finished_signal->up();
 
-			/* do post checkpoint */
-			post_checkpoint();
+		/* do post checkpoint */
+		post_checkpoint();
 
-			/* not busy */
-			_ready_event.set();
-		}
+		/* not busy */
+		_ready_event.set();
 	}
 }
 
@@ -96,16 +144,32 @@ void Checkpointable::start_checkpoint()
 	_ready_event.wait(); // wait until a checkpoint is possible.
 	_next_job = CHECKPOINT;
 	_checkpoint_finished.unset(); // must come before trigger next job.
-	_next_event.set();
+	if(_pool)
+		_queue = _pool->submit(*this, _worker);
+	else
+		_next_event.set();
 }
 
 
 void Checkpointable::join_checkpoint()
 {
+	/* execute the checkpoint, if no worker took it yet */
+	execute_queued();
+
 	_checkpoint_finished.wait();
 }
 
 
+bool Checkpointable::execute_queued()
+{
+	if(!_pool || !_pool->withdraw(*this, _queue))
+		return false;
+
+	_execute();
+	return true;
+}
+
+
 void Checkpointable::wait_ready()
 {
 	_ready_event.wait();
@@ -0,0 +1,157 @@
+/*
+ * \brief  Pool of pre-allocated cold dataspaces
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#include <rtcr/pd/cold_pool.h>
+
+#ifdef PROFILE
+#include <util/profiler.h>
+#define PROFILE_THIS_CALL PROFILE_FUNCTION("orange");
+#else
+#define PROFILE_THIS_CALL
+#endif
+
+#if DEBUG
+#define DEBUG_THIS_CALL Genode::log("\e[38;5;214m", __PRETTY_FUNCTION__, "\033[0m");
+#else
+#define DEBUG_THIS_CALL
+#endif
+
+using namespace Rtcr;
+
+
+Cold_pool::Cold_pool(Genode::Env &env, Genode::Allocator &alloc, unsigned count)
+	:
+	Thread(env, "cold_pool", 16*1024),
+	_env(env),
+	_alloc(alloc),
+	_count(count),
+	_running(true)
+{
+	DEBUG_THIS_CALL;
+
+	for(unsigned i = 0; i < NUM_CLASSES; i++)
+		_available[i] = 0;
+
+	/* the pool is filled by the background thread */
+	_refill_event.set();
+	Thread::start();
+}
+
+
+Cold_pool::~Cold_pool()
+{
+	_running = false;
+	_refill_event.set();
+	join();
+
+	for(unsigned i = 0; i < NUM_CLASSES; i++) {
+		while(Buffer *buffer = _buffers[i].first()) {
+			_buffers[i].remove(buffer);
+			_env.rm().detach(buffer->addr);
+			_env.ram().free(buffer->cap);
+			Genode::destroy(_alloc, buffer);
+		}
+	}
+}
+
+
+int Cold_pool::_size_class(Genode::size_t size)
+{
+	if(!size || size > (1UL << MAX_SIZE_LOG2))
+		return -1;
+
+	int size_class = 0;
+	while(_class_size(size_class) < size)
+		size_class++;
+	return size_class;
+}
+
+
+void Cold_pool::entry()
+{
+	while(_running) {
+		_refill_event.wait();
+		_refill_event.unset();
+
+		if(_running)
+			_refill();
+	}
+}
+
+
+void Cold_pool::_refill()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	for(int i = 0; i < NUM_CLASSES && _running; i++) {
+		while(true) {
+			{
+				Genode::Lock::Guard guard(_lock);
+				if(_available[i] >= _count)
+					break;
+			}
+
+			/* allocate outside of the lock, so that take() is not delayed */
+			Genode::Ram_dataspace_capability cap;
+			try {
+				cap = _env.ram().alloc(_class_size(i));
+			} catch(...) {
+				Genode::warning("Cold pool: cannot allocate ", _class_size(i), " bytes");
+				return;
+			}
+			void *addr = _env.rm().attach(cap);
+
+			Genode::Lock::Guard guard(_lock);
+			_buffers[i].insert(new (_alloc) Buffer(cap, addr));
+			_available[i]++;
+		}
+	}
+}
+
+
+bool Cold_pool::take(Ram_dataspace &ds)
+{
+	int const size_class = _size_class(ds.i_size);
+	if(size_class < 0)
+		return false;
+
+	Buffer *buffer;
+	{
+		Genode::Lock::Guard guard(_lock);
+		buffer = _buffers[size_class].first();
+		if(buffer) {
+			_buffers[size_class].remove(buffer);
+			_available[size_class]--;
+		}
+	}
+	_refill_event.set();
+
+	if(!buffer)
+		return false;
+
+	ds.i_dst_cap = buffer->cap;
+	ds.dst_cap = buffer->cap;
+	ds.dst = buffer->addr;
+	ds.cold_size = _class_size(size_class);
+	Genode::destroy(_alloc, buffer);
+	return true;
+}
+
+
+bool Cold_pool::put(Ram_dataspace &ds)
+{
+	int const size_class = _size_class(ds.cold_size);
+	if(size_class < 0 || _class_size(size_class) != ds.cold_size)
+		return false;
+
+	Genode::Lock::Guard guard(_lock);
+	if(_available[size_class] >= _count)
+		return false;
+
+	_buffers[size_class].insert(new (_alloc) Buffer(ds.dst_cap, ds.dst));
+	_available[size_class]++;
+	return true;
+}
@@ -6,6 +6,7 @@
  */
 
 #include <rtcr/cpu/cpu_session.h>
+#include <rtcr/tracer.h>
 
 #ifdef PROFILE
 #include <util/profiler.h>
@@ -31,6 +32,7 @@ Cpu_session::Cpu_session(Genode::Env &env,
 	:
 	Checkpointable(env, "cpu_session"),
 	Cpu_session_info(creation_args, cap().local_name()),
+	_cpu_threads     (md_alloc),
 	_env             (env),
 	_md_alloc        (md_alloc),
 	_config (env, "config"),
@@ -44,6 +46,13 @@ Cpu_session::Cpu_session(Genode::Env &env,
 
 	_ep.rpc_ep().manage(this);
 	child_info->cpu_session = this;	
+
+	/* start workers for pausing the threads in parallel */
+	_num_pause_workers = _read_pause_workers();
+	for(unsigned i = 0; i < _num_pause_workers; i++) {
+		Genode::String<32> const name("cpu_pause_worker_", i);
+		_pause_workers.insert(new (md_alloc) Pause_worker(env, *this, i + 1, name.string()));
+	}
 }
 
 
@@ -52,6 +61,13 @@ Cpu_session::~Cpu_session()
 	_cleanup_native_cpu();
 	_ep.rpc_ep().dissolve(this);
 	_child_info->cpu_session = nullptr;	
+
+	while(Pause_worker *worker = _pause_workers.first()) {
+		_pause_workers.remove(worker);
+		worker->stop();
+		Genode::destroy(_md_alloc, worker);
+	}
+
 	while(Cpu_thread_info *cpu_thread_info = _cpu_threads.first()) {
 		_cpu_threads.remove(cpu_thread_info);
 		Genode::destroy(_md_alloc, cpu_thread_info);
@@ -108,6 +124,16 @@ void Cpu_session::_kill_thread(Cpu_thread_info &cpu_thread_info)
 }
 
 
+unsigned Cpu_session::_read_pause_workers()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("pause_workers", 0U);
+	} catch(...) { }
+	return 0;
+}
+
+
 Genode::Affinity::Location Cpu_session::_read_child_affinity(const char* child_name)
 {
 	try {
@@ -134,7 +160,10 @@ void Cpu_session::checkpoint()
 	i_sigh_badge = _sigh.local_name();
 
 	_destroyed_cpu_threads.dequeue_all([&] (Cpu_thread_info &cpu_thread) {
-			_cpu_threads.remove(&cpu_thread);
+			{
+				Genode::Lock::Guard guard(_cpu_threads_lock);
+				_cpu_threads.remove(&cpu_thread);
+			}
 			Genode::destroy(_md_alloc, &cpu_thread);
 		});
 
@@ -148,33 +177,69 @@ void Cpu_session::checkpoint()
 	i_cpu_thread_info = _cpu_threads.first();
 }
 
-void Cpu_session::pause()
+Cpu_session::Pause_span Cpu_session::_pause_threads(unsigned share, bool resume)
 {
-	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+	Pause_span span;
+	unsigned const shares = _num_pause_workers + 1;
 
+	unsigned index = 0;
 	Cpu_thread_info *cpu_thread = _cpu_threads.first();
-	while(cpu_thread) {
+	for(; cpu_thread; cpu_thread = cpu_thread->next(), index++) {
 		/* if the object is in the destroyed queue, it means that it is already
 		 * destroyed */
-		if(!cpu_thread->enqueued())
+		if(index % shares != share || cpu_thread->enqueued())
+			continue;
+
+		if(resume)
+			static_cast<Cpu_thread*>(cpu_thread)->silent_resume();
+		else
 			static_cast<Cpu_thread*>(cpu_thread)->silent_pause();
-		cpu_thread = cpu_thread->next();
+		span.add(elapsed_us());
+	}
+	return span;
+}
+
+
+void Cpu_session::Pause_worker::checkpoint()
+{
+	span = _cpu._pause_threads(_share, _cpu._resuming);
+}
+
+
+Cpu_session::Pause_span Cpu_session::_pause_all_threads(bool resume)
+{
+	_resuming = resume;
+
+	Pause_worker *worker;
+	for(worker = _pause_workers.first(); worker; worker = worker->next())
+		worker->start_checkpoint();
+
+	Pause_span span = _pause_threads(0, resume);
+
+	for(worker = _pause_workers.first(); worker; worker = worker->next()) {
+		worker->join_checkpoint();
+		span.add(worker->span);
 	}
-	_cpu_threads_lock.unlock();
+	return span;
+}
+
+
+void Cpu_session::pause()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+	Tracer::Scope trace("pause");
+
+	_paused_at = elapsed_us();
+	_pause_skew = _pause_all_threads(false).length();
 }
 
 void Cpu_session::resume()
 {
 	DEBUG_THIS_CALL PROFILE_THIS_CALL
+	Tracer::Scope trace("resume");
 
-		Cpu_thread_info *cpu_thread = _cpu_threads.first();
-	while(cpu_thread) {
-		/* if the object is in the destroyed queue, it means that it is already
-		 * destroyed */
-		if(!cpu_thread->enqueued())
-			static_cast<Cpu_thread*>(cpu_thread)->silent_resume();
-		cpu_thread = cpu_thread->next();
-	}
+	_pause_all_threads(true);
+	_pause_time = elapsed_us() - _paused_at;
 }
 
 
@@ -210,8 +275,7 @@ void Cpu_session::kill_thread(Genode::Thread_capability thread_cap)
 {
 	/*  Find CPU thread for the given capability */
 	Genode::Lock::Guard lock (_cpu_threads_lock);
-	Cpu_thread_info *cpu_thread = _cpu_threads.first();
-	if(cpu_thread) cpu_thread = cpu_thread->find_by_badge(thread_cap.local_name());
+	Cpu_thread_info *cpu_thread = _cpu_threads.find_by_badge(thread_cap.local_name());
 	if(cpu_thread) {
 		Genode::error("Issuing Rm_session::destroy, which is bugged and hangs up.");
 		_kill_thread(*cpu_thread);
@@ -28,15 +28,99 @@ Init_module::Init_module(Genode::Env &env, Genode::Allocator &alloc)
 	_alloc(alloc),
 	_config(env, "config"),
 	_parallel(read_parallel()),
+	_precopy_rounds(read_precopy_rounds()),
+	_precopy_threshold(read_precopy_threshold()),
+	_concurrent_childs(read_concurrent_childs()),
+	_timer(env),
 	_reporter(env, "rtcr_state")
 {
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	add_stage(_pd_stage);
+	add_stage(_ram_stage);
+	add_stage(_cpu_stage);
+	add_stage(_rm_stage);
+	add_stage(_rom_stage);
+	add_stage(_log_stage);
+	add_stage(_timer_stage);
+	add_stage(_capability_mapping_stage);
+
+	/* the capability mapping refers to the capabilities of all sessions,
+	 * but not to the memory of the Ram dataspaces */
+	_capability_mapping_stage.depends_on(_pd_stage.name);
+	_capability_mapping_stage.depends_on(_cpu_stage.name);
+	_capability_mapping_stage.depends_on(_rm_stage.name);
+	_capability_mapping_stage.depends_on(_rom_stage.name);
+	_capability_mapping_stage.depends_on(_log_stage.name);
+	_capability_mapping_stage.depends_on(_timer_stage.name);
+
+	Genode::size_t const trace_entries = read_trace_entries();
+	if(trace_entries)
+		_tracer.construct(env, alloc, trace_entries);
+
+	for(unsigned i = 0; _concurrent_childs > 1 && i < _concurrent_childs; i++) {
+		Genode::String<32> const name("child_checkpointer_", i);
+		_child_checkpointers.insert(new (_alloc) Child_checkpointer(env, *this, name.string()));
+	}
 }
 
 
-Init_module::~Init_module()
+void Init_module::add_stage(Stage &stage)
+{
+	if(_num_stages == MAX_STAGES) {
+		Genode::error("Stage ", stage.name, " exceeds the maximum of ", (unsigned)MAX_STAGES, " stages");
+		return;
+	}
+	_num_stages++;
+	_stages.insert(&stage, _last_stage);
+	_last_stage = &stage;
+}
+
+
+Init_module::Stage *Init_module::stage(Stage::Name const &name)
 {
+	for(Stage *s = _stages.first(); s; s = s->next())
+		if(s->name == name) return s;
+	return nullptr;
+}
+
+
+Checkpointable *Init_module::Session_stage::checkpointable(Child_info &child)
+{
+	/* well...casting is not that efficent, but due to the design of
+	 * *_info object handling..this is necessary */
+	Pd_session *pd_session = static_cast<Pd_session*>(child.pd_session);
+
+	switch(session) {
+	case PD:
+		return &pd_session->pd_checkpointable;
+
+	case RAM:
+		/* in the copy-on-write mode, memory is copied after resuming the
+		 * child, in the double-buffered mode, memory is copied by
+		 * checkpoint() */
+		if(pd_session->snapshot_mode() || pd_session->double_buffered())
+			return nullptr;
+		return &pd_session->ram_checkpointable;
+
+	case CPU:    return static_cast<Cpu_session*>(child.cpu_session);
+	case RM:     return static_cast<Rm_session*>(child.rm_session);
+	case ROM:    return static_cast<Rom_session*>(child.rom_session);
+	case LOG:    return static_cast<Log_session*>(child.log_session);
+	case TIMER:  return static_cast<Timer_session*>(child.timer_session);
+	case CAPABILITY_MAPPING: return child.capability_mapping;
+	}
+	return nullptr;
+}
 
+
+Init_module::~Init_module()
+{
+	while(Child_checkpointer *checkpointer = _child_checkpointers.first()) {
+		_child_checkpointers.remove(checkpointer);
+		checkpointer->stop();
+		Genode::destroy(_alloc, checkpointer);
+	}
 }
 
 
@@ -54,6 +138,46 @@ bool Init_module::read_parallel()
 }
 
 
+unsigned Init_module::read_precopy_rounds()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("precopy_rounds", 0U);
+	} catch(...) { }
+	return 0;
+}
+
+
+Genode::size_t Init_module::read_precopy_threshold()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value<unsigned long>("precopy_threshold", 0);
+	} catch(...) { }
+	return 0;
+}
+
+
+unsigned Init_module::read_concurrent_childs()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("concurrent_childs", 1U);
+	} catch(...) { }
+	return 1;
+}
+
+
+Genode::size_t Init_module::read_trace_entries()
+{
+	try {
+		Genode::Xml_node trace_node = _config.xml().sub_node("trace");
+		return trace_node.attribute_value("entries", 4096UL);
+	} catch(...) { }
+	return 0;
+}
+
+
 Child_info *Init_module::child_info(const char* name)
 {
 	Child_info *child = _childs.first();
@@ -62,44 +186,232 @@ Child_info *Init_module::child_info(const char* name)
 }
 
 
-void Init_module::pause()
+void Init_module::pause(Child_selection const &selection)
 {
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
-	_childs_lock.lock();
-	Child_info *child = _childs.first();
-	while(child) {
+	Genode::Lock::Guard guard(_childs_lock);
+	for(Child_info *child = _childs.first(); child; child = child->next()) {
+		if(!selection.selected(*child)) continue;
 		Genode::log("pause: child=",child->name);
 		static_cast<Cpu_session*>(child->cpu_session)->pause();
-		child = child->next();
 	}
-	_childs_lock.unlock();
 }
 
 
-void Init_module::resume()
+void Init_module::resume(Child_selection const &selection)
 {
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
-	_childs_lock.lock();
+	Genode::Lock::Guard guard(_childs_lock);
+	for(Child_info *child = _childs.first(); child; child = child->next())
+		if(selection.selected(*child))
+			static_cast<Cpu_session*>(child->cpu_session)->resume();
+}
+
+
+void Init_module::checkpoint()
+{
+	checkpoint(_all_childs);
+}
+
+
+void Init_module::checkpoint(Child_selection const &selection)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	_selection = &selection;
+	if(_tracer.constructed()) _tracer->begin("checkpoint");
+
+	unsigned long long const start = _timer.elapsed_us();
+
+	/* copy most of the memory while the childs are running */
+	_precopy_rounds_done = _precopy_rounds ? precopy() : 0;
+
+	bool const snapshot = snapshot_mode();
+	bool const concurrent = _concurrent_childs > 1;
+	if((_precopy_rounds || snapshot) && !concurrent) pause(selection);
+
+	unsigned long long const pause_start = _timer.elapsed_us();
+	bool const double_buffered = double_buffered_mode();
+	Child_info *child;
+
+	/* the memory is copied into the back buffers while the last checkpoint
+	 * may still be serialized. In the concurrent mode, each child is paused
+	 * first by checkpoint_child(). */
+	if(double_buffered && !concurrent)
+		for(child = _childs.first(); child; child = child->next())
+			if(selected(*child))
+				static_cast<Pd_session*>(child->pd_session)->ram_checkpointable.start_checkpoint();
+
+	{
+		Genode::Lock::Guard guard(_generation_lock);
+
+		if(concurrent)
+			checkpoint_concurrently(_precopy_rounds || snapshot);
+		else
+			for(child = _childs.first(); child; child = child->next())
+				if(selected(*child))
+					checkpoint_child(*child, false, false);
+
+		if(double_buffered) {
+			for(child = _childs.first(); child; child = child->next())
+				if(selected(*child))
+					static_cast<Pd_session*>(child->pd_session)->ram_checkpointable.join_checkpoint();
+			for(child = _childs.first(); child; child = child->next()) {
+				if(!selected(*child)) continue;
+				Pd_session &pd_session = *static_cast<Pd_session*>(child->pd_session);
+				if(pd_session.ram_checkpoint_complete())
+					pd_session.flip_ram_dataspaces();
+			}
+		}
+	}
+	_pause_time = _timer.elapsed_us() - pause_start;
+	_pause_latency.record(_pause_time);
+
+	if((_precopy_rounds || snapshot) && !concurrent) resume(selection);
+
+	/* copy the write-protected memory while the childs are running */
+	if(snapshot) {
+		for(child = _childs.first(); child; child = child->next())
+			if(selected(*child))
+				static_cast<Pd_session*>(child->pd_session)->ram_checkpointable.start_checkpoint();
+		for(child = _childs.first(); child; child = child->next())
+			if(selected(*child))
+				static_cast<Pd_session*>(child->pd_session)->ram_checkpointable.join_checkpoint();
+	}
+
+	_checkpoint_time = _timer.elapsed_us() - start;
+	_checkpoint_latency.record(_checkpoint_time);
+
+	if(_tracer.constructed()) {
+		_tracer->end("checkpoint");
+		_tracer->dump();
+	}
+
+	if(_reporter.enabled()) report();
+	_selection = nullptr;
+}
+
+
+bool Init_module::snapshot_mode()
+{
 	Child_info *child = _childs.first();
 	while(child) {
-		static_cast<Cpu_session*>(child->cpu_session)->resume();
+		if(static_cast<Pd_session*>(child->pd_session)->snapshot_mode())
+			return true;
 		child = child->next();
 	}
-	_childs_lock.unlock();
+	return false;
 }
 
 
-void Init_module::checkpoint()
+bool Init_module::checkpoint_complete()
+{
+	Child_info *child = _childs.first();
+	while(child) {
+		if(!static_cast<Pd_session*>(child->pd_session)->ram_checkpoint_complete())
+			return false;
+		child = child->next();
+	}
+	return true;
+}
+
+
+bool Init_module::double_buffered_mode()
 {
-	DEBUG_THIS_CALL PROFILE_THIS_CALL;
-	
 	Child_info *child = _childs.first();
 	while(child) {
-		checkpoint(child);
+		if(static_cast<Pd_session*>(child->pd_session)->double_buffered())
+			return true;
 		child = child->next();
 	}
+	return false;
+}
+
+
+unsigned Init_module::precopy()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	unsigned round = 0;
+	while(round < _precopy_rounds) {
+		round++;
+
+		Genode::size_t pages = 0;
+		Child_info *child = _childs.first();
+		while(child) {
+			if(selected(*child))
+				pages += static_cast<Pd_session*>(child->pd_session)->precopy_ram_dataspaces();
+			child = child->next();
+		}
+
+#ifdef VERBOSE
+		Genode::log("Pre-copy round ", round, ": ", pages, " pages");
+#endif
+		/* the dirty set converged */
+		if(pages <= _precopy_threshold)
+			break;
+	}
+	return round;
+}
+
+
+Child_info *Init_module::take_next_child()
+{
+	Genode::Lock::Guard guard(_next_child_lock);
+	Child_info *child = _next_child;
+	while(child && !selected(*child))
+		child = child->next();
+	if(child) _next_child = child->next();
+	return child;
+}
+
+
+void Init_module::Child_checkpointer::checkpoint()
+{
+	while(Child_info *child = _module.take_next_child())
+		_module.checkpoint_child(*child, _module._pause_each, true);
+}
+
+
+void Init_module::checkpoint_concurrently(bool pause)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	_pause_each = pause;
+	_next_child = _childs.first();
+
+	Child_checkpointer *checkpointer;
+	for(checkpointer = _child_checkpointers.first(); checkpointer; checkpointer = checkpointer->next())
+		checkpointer->start_checkpoint();
+	for(checkpointer = _child_checkpointers.first(); checkpointer; checkpointer = checkpointer->next())
+		checkpointer->join_checkpoint();
+}
+
+
+void Init_module::checkpoint_child(Child_info &child, bool pause, bool concurrent)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	Pd_session &pd_session = *static_cast<Pd_session*>(child.pd_session);
+	Cpu_session &cpu_session = *static_cast<Cpu_session*>(child.cpu_session);
+
+	if(pause) cpu_session.pause();
+
+	if(concurrent && pd_session.double_buffered())
+		pd_session.ram_checkpointable.start_checkpoint();
+
+	if(pd_session.snapshot_mode())
+		pd_session.snapshot_ram_dataspaces();
+	checkpoint(&child);
+
+	/* the back buffers must not be modified by the child until they are
+	 * copied, the buffers are flipped after all childs are checkpointed */
+	if(pause && pd_session.double_buffered())
+		pd_session.ram_checkpointable.join_checkpoint();
+
+	if(pause) cpu_session.resume();
 }
 
 
@@ -107,73 +419,91 @@ void Init_module::checkpoint(Child_info *child)
 {
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
-	/* well...casting is not that efficent, but due to the design of
-	 * *_info object handling..this is necessary */
-	Pd_session::Pd_checkpointable &pd = static_cast<Pd_session*>(child->pd_session)->pd_checkpointable;
-	Pd_session::Ram_checkpointable &ram = static_cast<Pd_session*>(child->pd_session)->ram_checkpointable;
-
-	Cpu_session *cpu_session = static_cast<Cpu_session*>(child->cpu_session);
-	Rm_session *rm_session = static_cast<Rm_session*>(child->rm_session);
-	Rom_session *rom_session = static_cast<Rom_session*>(child->rom_session);
-	Timer_session *timer_session = static_cast<Timer_session*>(child->timer_session);
-	Log_session *log_session = static_cast<Log_session*>(child->log_session);
-	Capability_mapping *capability_mapping = child->capability_mapping;
-
-	if(_parallel) {
-		/* start all checkpointing threads */
-		capability_mapping->start_checkpoint();
-
-		pd.start_checkpoint();
-		ram.start_checkpoint();
-		cpu_session->start_checkpoint();
-
-		if(rm_session) rm_session->start_checkpoint();
-		if(rom_session) rom_session->start_checkpoint();
-		if(log_session) log_session->start_checkpoint();
-		if(timer_session) timer_session->start_checkpoint();
-
-		/* wait until all threads finished */
-		capability_mapping->join_checkpoint();
-		pd.join_checkpoint();
-		ram.join_checkpoint();
-		cpu_session->join_checkpoint();
-
-		if(rm_session) rm_session->join_checkpoint();
-		if(rom_session) rom_session->join_checkpoint();
-		if(log_session) log_session->join_checkpoint();
-		if(timer_session) timer_session->join_checkpoint();
-	} else {
-		/* start & wait for pd_session */
-		pd.start_checkpoint();
-		pd.join_checkpoint();
-
-		ram.start_checkpoint();
-		ram.join_checkpoint();
-		
-		/* start & wait for cpu_session */
-		cpu_session->start_checkpoint();
-		cpu_session->join_checkpoint();
-
-		/* start & wait for rm_session */
-		if(rm_session) rm_session->start_checkpoint();
-		if(rm_session) rm_session->join_checkpoint();
-
-		/* start & wait for rom_session */
-		if(rom_session) rom_session->start_checkpoint();
-		if(rom_session) rom_session->join_checkpoint();
-
-		/* start & wait for log_session */
-		if(log_session) log_session->start_checkpoint();
-		if(log_session) log_session->join_checkpoint();
-
-		/* start & wait for timer_session */
-		if(timer_session) timer_session->start_checkpoint();
-		if(timer_session) timer_session->join_checkpoint();
-
-		/* start & wait for capability_mapping */
-		capability_mapping->start_checkpoint();
-		capability_mapping->join_checkpoint();
+	struct State
+	{
+		Stage *stage;
+		Checkpointable *checkpointable;
+		bool started;
+		bool finished;
+	} state[MAX_STAGES];
+
+	unsigned n = 0;
+	for(Stage *s = _stages.first(); s && n < MAX_STAGES; s = s->next())
+		state[n++] = { s, s->checkpointable(*child), false, false };
+
+	auto finished = [&] (Stage::Name const &name) {
+		for(unsigned i = 0; i < n; i++)
+			if(state[i].stage->name == name) return state[i].finished;
+		return true;
+	};
+
+	auto ready = [&] (Stage const &stage) {
+		for(unsigned d = 0; d < stage.num_dependencies; d++)
+			if(!finished(stage.dependencies[d])) return false;
+		return true;
+	};
+
+	/* upped by each started stage when it finishes */
+	Genode::Semaphore finished_stages;
+	unsigned running = 0;
+
+	unsigned done = 0;
+	while(done < n) {
+		bool started = false;
+		for(unsigned i = 0; i < n; i++) {
+			if(state[i].started || !ready(*state[i].stage))
+				continue;
+
+			state[i].started = started = true;
+			if(!state[i].checkpointable) {
+				state[i].finished = true;
+				done++;
+				continue;
+			}
+
+			/* in the sequential mode, each stage is joined right away */
+			if(_parallel) {
+				state[i].checkpointable->finished_signal(&finished_stages);
+				state[i].checkpointable->start_checkpoint();
+				running++;
+			} else {
+				state[i].checkpointable->start_checkpoint();
+				state[i].checkpointable->join_checkpoint();
+				state[i].finished = true;
+				done++;
+			}
+		}
+
+		/* join the stage which finished first, which may start its dependents */
+		if(running) {
+			/* the calling thread may be a worker of the pool, which must not
+			 * wait for stages queued behind itself */
+			for(unsigned i = 0; i < n; i++)
+				if(state[i].started && !state[i].finished && state[i].checkpointable
+				 && state[i].checkpointable->execute_queued())
+					break;
+
+			finished_stages.down();
+			for(unsigned i = 0; i < n; i++) {
+				if(!state[i].started || state[i].finished || !state[i].checkpointable
+				 || !state[i].checkpointable->checkpoint_finished())
+					continue;
+				state[i].checkpointable->join_checkpoint();
+				state[i].finished = true;
+				running--;
+				done++;
+				break;
+			}
+		} else if(!started) {
+			Genode::error("Checkpoint stages have cyclic dependencies");
+			break;
+		}
 	}
+
+	/* the semaphore was downed once per up, so no stage refers to it anymore */
+	for(unsigned i = 0; i < n; i++)
+		if(state[i].checkpointable)
+			state[i].checkpointable->finished_signal(nullptr);
 }
 
 
@@ -183,9 +513,42 @@ void Init_module::report_enabled(bool enabled)
 }
 
 
+/**
+ * Add the statistics of `latency` as `latency` node
+ */
+static void report_latency(Genode::Xml_generator &xml, char const *stage,
+                           Latency_histogram const &latency)
+{
+	if(!latency.count())
+		return;
+
+	xml.node("latency", [&] () {
+		xml.attribute("stage", stage);
+		xml.attribute("count", latency.count());
+		xml.attribute("min", latency.min());
+		xml.attribute("max", latency.max());
+		xml.attribute("mean", latency.mean());
+		xml.attribute("p50", latency.percentile(500));
+		xml.attribute("p99", latency.percentile(990));
+		xml.attribute("p999", latency.percentile(999));
+
+		latency.for_each_bucket([&] (Latency_histogram::Us below, unsigned long count) {
+			xml.node("bucket", [&] () {
+				xml.attribute("below", below);
+				xml.attribute("count", count);
+			});
+		});
+	});
+}
+
+
 void Init_module::report()
 {
 	Genode::Reporter::Xml_generator xml(_reporter, [&] () {
+			xml.attribute("checkpoint_time", _checkpoint_time);
+			xml.attribute("pause_time", _pause_time);
+			if(_precopy_rounds) xml.attribute("precopy_rounds", _precopy_rounds_done);
+
 			Child_info *child = _childs.first();
 			while(child) {				
 				Pd_session::Pd_checkpointable *pd_session = &static_cast<Pd_session*>(child->pd_session)->pd_checkpointable;
@@ -201,6 +564,8 @@ void Init_module::report()
 				xml.node("child", [&] () {
 						xml.attribute("name",   child->name);
 						if(cpu_session) xml.attribute("cpu_session", cpu_session->checkpoint_time());
+						if(cpu_session) xml.attribute("pause_time", cpu_session->pause_time());
+						if(cpu_session) xml.attribute("pause_skew", cpu_session->pause_skew());
 						if(rm_session) xml.attribute("rm_session", rm_session->checkpoint_time());
 						if(rom_session) xml.attribute("rom_session", rom_session->checkpoint_time());
 						if(timer_session) xml.attribute("timer_session", timer_session->checkpoint_time());
@@ -208,9 +573,43 @@ void Init_module::report()
 						if(capability_mapping) xml.attribute("capability_mapping", capability_mapping->checkpoint_time());
 						if(pd_session) xml.attribute("pd_session", pd_session->checkpoint_time());
 						if(ram_dataspaces) xml.attribute("ram_dataspaces", ram_dataspaces->checkpoint_time());
+						if(ram_dataspaces && ram_dataspaces->_pd->zero_pages_elided())
+							xml.attribute("zero_pages", ram_dataspaces->_pd->zero_pages());
+						if(ram_dataspaces && ram_dataspaces->_pd->time_bounded()) {
+							xml.attribute("ram_slice_bytes", ram_dataspaces->_pd->ram_slice_bytes());
+							xml.attribute("ram_complete", ram_dataspaces->_pd->ram_checkpoint_complete());
+						}
+						if(ram_dataspaces && ram_dataspaces->_pd->compression()) {
+							xml.attribute("compressed_dataspaces", ram_dataspaces->_pd->compressed_dataspaces());
+							xml.attribute("compressed_bytes", ram_dataspaces->_pd->compressed_bytes());
+						}
+						if(ram_dataspaces && ram_dataspaces->_pd->hot_ordering())
+							xml.attribute("hot_dataspaces", ram_dataspaces->_pd->hot_dataspaces());
+						if(ram_dataspaces && ram_dataspaces->_pd->dataspace_classifier())
+							xml.attribute("immutable_dataspaces", ram_dataspaces->_pd->immutable_dataspaces());
+						if(ram_dataspaces && ram_dataspaces->_pd->hash_mode()) {
+							xml.attribute("hash_hits", ram_dataspaces->_pd->hash_hits());
+							xml.attribute("hash_misses", ram_dataspaces->_pd->hash_misses());
+						}
+						if(ram_dataspaces) {
+							xml.attribute("copied_bytes", ram_dataspaces->_pd->copied_pages()*Ram_dataspace::PAGE_SIZE);
+							xml.attribute("skipped_pages", ram_dataspaces->_pd->skipped_pages());
+						}
+
+						if(cpu_session) report_latency(xml, "cpu_session", cpu_session->latency());
+						if(rm_session) report_latency(xml, "rm_session", rm_session->latency());
+						if(rom_session) report_latency(xml, "rom_session", rom_session->latency());
+						if(timer_session) report_latency(xml, "timer_session", timer_session->latency());
+						if(log_session) report_latency(xml, "log_session", log_session->latency());
+						if(capability_mapping) report_latency(xml, "capability_mapping", capability_mapping->latency());
+						if(pd_session) report_latency(xml, "pd_session", pd_session->latency());
+						if(ram_dataspaces) report_latency(xml, "ram_dataspaces", ram_dataspaces->latency());
 					});
 				child = child->next();
 			}	
+
+			report_latency(xml, "checkpoint", _checkpoint_latency);
+			report_latency(xml, "pause", _pause_latency);
 		});
 }
    
@@ -0,0 +1,191 @@
+/*
+ * \brief  Fast compression of cold dataspaces
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ *
+ * The encoder produces the LZ4 block format: a sequence of literals, each
+ * followed by a back reference of at least four bytes into the last 64 KiB.
+ * It finds matches through a single hash table without chains, which trades
+ * compression ratio for speed.
+ */
+
+#include <util/lz4.h>
+#include <util/string.h>
+
+using namespace Rtcr;
+using Genode::uint8_t;
+using Genode::uint32_t;
+using Genode::size_t;
+
+namespace {
+
+	enum {
+		MIN_MATCH     = 4,
+		MF_LIMIT      = 12,
+		LAST_LITERALS = 5,
+		MAX_OFFSET    = 65535,
+	};
+
+	inline uint32_t read32(uint8_t const *p)
+	{
+		uint32_t v;
+		Genode::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline unsigned hash(uint32_t sequence)
+	{
+		return (sequence*2654435761U) >> (32 - Lz4::HASH_LOG);
+	}
+
+	/**
+	 * Write a length, which does not fit into the four bits of the token
+	 */
+	inline uint8_t *write_length(uint8_t *op, size_t length)
+	{
+		for(length -= 15; length >= 255; length -= 255)
+			*op++ = 255;
+		*op++ = (uint8_t)length;
+		return op;
+	}
+
+	/**
+	 * Read a length, which does not fit into the four bits of the token
+	 *
+	 * \return false, if the input ends within the length
+	 */
+	inline bool read_length(uint8_t const *&ip, uint8_t const *iend, size_t &length)
+	{
+		uint8_t b;
+		do {
+			if(ip >= iend) return false;
+			b = *ip++;
+			length += b;
+		} while(b == 255);
+		return true;
+	}
+}
+
+
+size_t Lz4::compress(void const *src, size_t size, void *dst, size_t capacity,
+                     Hash_table &table)
+{
+	uint8_t const *const in = (uint8_t const*)src;
+	uint8_t const *const end = in + size;
+	uint8_t const *ip = in;
+	uint8_t const *anchor = in;
+	uint8_t *const out = (uint8_t*)dst;
+	uint8_t *const oend = out + capacity;
+	uint8_t *op = out;
+
+	Genode::memset(table.slot, 0, sizeof(table.slot));
+
+	if(size > MF_LIMIT) {
+		uint8_t const *const match_limit = end - MF_LIMIT;
+		uint8_t const *const extend_limit = end - LAST_LITERALS;
+
+		while(ip < match_limit) {
+			uint32_t const sequence = read32(ip);
+			unsigned const h = hash(sequence);
+			uint8_t const *ref = in + table.slot[h];
+			table.slot[h] = (uint32_t)(ip - in);
+
+			if(ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != sequence) {
+				/* skip faster through incompressible data */
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			uint8_t const *mp = ip + MIN_MATCH;
+			uint8_t const *rp = ref + MIN_MATCH;
+			while(mp < extend_limit && *mp == *rp) {
+				mp++;
+				rp++;
+			}
+
+			size_t const literals = ip - anchor;
+			size_t const match = mp - ip - MIN_MATCH;
+			if((size_t)(oend - op) < 1 + literals/255 + 1 + literals + 2 + match/255 + 1)
+				return 0;
+
+			uint8_t *token = op++;
+			*token = (uint8_t)((literals < 15 ? literals : 15) << 4);
+			if(literals >= 15) op = write_length(op, literals);
+			Genode::memcpy(op, anchor, literals);
+			op += literals;
+
+			size_t const offset = ip - ref;
+			*op++ = (uint8_t)(offset & 0xff);
+			*op++ = (uint8_t)(offset >> 8);
+
+			*token |= (uint8_t)(match < 15 ? match : 15);
+			if(match >= 15) op = write_length(op, match);
+
+			ip = mp;
+			anchor = ip;
+		}
+	}
+
+	/* the last sequence consists of literals only */
+	size_t const literals = end - anchor;
+	if((size_t)(oend - op) < 1 + literals/255 + 1 + literals)
+		return 0;
+
+	*op++ = (uint8_t)((literals < 15 ? literals : 15) << 4);
+	if(literals >= 15) op = write_length(op, literals);
+	Genode::memcpy(op, anchor, literals);
+	op += literals;
+
+	return op - out;
+}
+
+
+size_t Lz4::decompress(void const *src, size_t size, void *dst, size_t capacity)
+{
+	uint8_t const *ip = (uint8_t const*)src;
+	uint8_t const *const iend = ip + size;
+	uint8_t *const out = (uint8_t*)dst;
+	uint8_t *const oend = out + capacity;
+	uint8_t *op = out;
+
+	while(ip < iend) {
+		unsigned const token = *ip++;
+
+		size_t literals = token >> 4;
+		if(literals == 15 && !read_length(ip, iend, literals))
+			return 0;
+		if(literals > (size_t)(iend - ip) || literals > (size_t)(oend - op))
+			return 0;
+		Genode::memcpy(op, ip, literals);
+		op += literals;
+		ip += literals;
+
+		/* the last sequence has no match */
+		if(ip >= iend)
+			break;
+
+		if(iend - ip < 2)
+			return 0;
+		size_t const offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if(offset == 0 || offset > (size_t)(op - out))
+			return 0;
+
+		size_t match = token & 15;
+		if(match == 15 && !read_length(ip, iend, match))
+			return 0;
+		match += MIN_MATCH;
+		if(match > (size_t)(oend - op))
+			return 0;
+
+		/* overlapping matches repeat the bytes just written */
+		uint8_t const *ref = op - offset;
+		if(offset >= match) {
+			Genode::memcpy(op, ref, match);
+			op += match;
+		} else {
+			while(match--) *op++ = *ref++;
+		}
+	}
+	return op - out;
+}
@@ -8,6 +8,8 @@
 #include <rtcr/pd/pd_session.h>
 
 #include <rtcr/cap/capability_mapping.h>
+#include <util/copy_engine.h>
+#include <rtcr/tracer.h>
 
 #ifdef PROFILE
 #include <util/profiler.h>
@@ -34,6 +36,10 @@ Pd_session::Pd_session(Genode::Env &env,
 	Pd_session_info(creation_args, cap().local_name()),
 	pd_checkpointable(env, this),
 	ram_checkpointable(env, this),
+	_signal_sources (md_alloc),
+	_signal_contexts (md_alloc),
+	_native_caps (md_alloc),
+	_ram_dataspaces (md_alloc),
 	_env (env),
 	_md_alloc (md_alloc),
 	_ep (ep),
@@ -56,7 +62,15 @@ Pd_session::Pd_session(Genode::Env &env,
 	              0,
 	              "linker_area",
 	              child_info->bootstrapped,
-	              ep)
+	              ep),
+	_config (env, "config"),
+	_copy_mode (_read_copy_mode()),
+	_zero_pages (_read_zero_pages()),
+	_double_buffered (_read_double_buffered()),
+	_time_budget (_read_time_budget()),
+	_hot_threshold (_read_hot_threshold()),
+	_compress_after (_read_compress_after()),
+	_chunk_size (_read_chunk_size())
 {
 	DEBUG_THIS_CALL;
 
@@ -66,6 +80,39 @@ Pd_session::Pd_session(Genode::Env &env,
 	i_stack_area = &_stack_area;
 	i_linker_area = &_linker_area;
 
+	/* track written pages of all Ram dataspaces attached by the child */
+	if(_copy_mode == INCREMENTAL || _copy_mode == COPY_ON_WRITE) {
+		_write_tracker.construct(env, md_alloc, ep, _ram_dataspaces_lock,
+		                         _ram_dataspaces, _read_granularity(),
+		                         _copy_mode == COPY_ON_WRITE);
+		_address_space.write_tracker(&*_write_tracker);
+		_stack_area.write_tracker(&*_write_tracker);
+		_linker_area.write_tracker(&*_write_tracker);
+	}
+
+	if(_compress_after)
+		_lz4_table.construct();
+
+	/* classify Ram dataspaces by their attachments */
+	if(_read_skip_immutable()) {
+		_classifier.construct(_ram_dataspaces_lock, _ram_dataspaces);
+		_address_space.classifier(&*_classifier);
+		_stack_area.classifier(&*_classifier);
+		_linker_area.classifier(&*_classifier);
+	}
+
+	/* pre-allocate cold dataspaces in the background */
+	unsigned const cold_pool = _read_cold_pool();
+	if(cold_pool)
+		_cold_pool.construct(env, md_alloc, cold_pool);
+
+	/* start workers for copying large dataspaces in parallel */
+	unsigned const copy_workers = _read_copy_workers();
+	for(unsigned i = 0; i < copy_workers; i++) {
+		Genode::String<32> const name("ram_copy_worker_", i);
+		_copy_workers.insert(new (md_alloc) Copy_worker(env, this, name.string()));
+	}
+
 	/* init capability mapping */
 	child_info->capability_mapping = new(md_alloc) Capability_mapping(env, md_alloc, this);
 	child_info->pd_session = this;
@@ -79,6 +126,12 @@ Pd_session::~Pd_session()
 	
 	_ep.rpc_ep().dissolve(this);
 
+	while(Copy_worker *worker = _copy_workers.first()) {
+		_copy_workers.remove(worker);
+		worker->stop();
+		Genode::destroy(_md_alloc, worker);
+	}
+
 	while(Signal_context_info *sc = _signal_contexts.first()) {
 		_signal_contexts.remove(sc);
 		Genode::destroy(_md_alloc, sc);
@@ -98,8 +151,155 @@ Pd_session::~Pd_session()
 
 	while(Ram_dataspace_info *ds = _ram_dataspaces.first()) {
 		_ram_dataspaces.remove(ds);
-		Genode::destroy(_md_alloc, ds);
+		Genode::destroy(_md_alloc, static_cast<Ram_dataspace*>(ds));
 	}	
+
+	while(Retired_dataspace *retired = _retired_dataspaces.first()) {
+		_retired_dataspaces.remove(retired);
+		_env.rm().detach(retired->addr);
+		_env.ram().free(retired->cap);
+		Genode::destroy(_md_alloc, retired);
+	}
+}
+
+
+Pd_session::Copy_mode Pd_session::_read_copy_mode()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		Genode::String<16> const mode = ck_node.attribute_value("copy", Genode::String<16>("full"));
+		if(mode == "incremental") return INCREMENTAL;
+		if(mode == "hash") return HASH;
+		if(mode == "cow") return COPY_ON_WRITE;
+		if(mode != "full") Genode::warning("Unknown copy mode '", mode, "', using full");
+	} catch(...) { }
+	return FULL;
+}
+
+
+Genode::size_t Pd_session::_read_granularity()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value<unsigned long>("granularity", 1);
+	} catch(...) { }
+	return 1;
+}
+
+
+unsigned Pd_session::_read_cold_pool()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("cold_pool", 0U);
+	} catch(...) { }
+	return 0;
+}
+
+
+unsigned Pd_session::_read_compress_after()
+{
+	unsigned checkpoints = 0;
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		checkpoints = ck_node.attribute_value("compress_after", 0U);
+	} catch(...) { }
+
+	if(checkpoints && (_copy_mode != INCREMENTAL || _double_buffered)) {
+		Genode::warning("Compression of cold dataspaces requires the incremental ",
+		                "copy mode without double buffering");
+		return 0;
+	}
+	return checkpoints;
+}
+
+
+unsigned Pd_session::_read_hot_threshold()
+{
+	unsigned percent = 0;
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		percent = ck_node.attribute_value("hot_threshold", 0U);
+	} catch(...) { }
+	return Genode::min(percent, 100U)*10;
+}
+
+
+unsigned long long Pd_session::_read_time_budget()
+{
+	unsigned long long budget = 0;
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		budget = ck_node.attribute_value("time_budget_us", 0ULL);
+	} catch(...) { }
+
+	if(budget && _copy_mode == COPY_ON_WRITE) {
+		Genode::warning("A time budget is not supported in the copy-on-write mode");
+		return 0;
+	}
+	return budget;
+}
+
+
+bool Pd_session::_read_skip_immutable()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("skip_immutable", false);
+	} catch(...) { }
+	return false;
+}
+
+
+bool Pd_session::_read_double_buffered()
+{
+	bool double_buffered = false;
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		double_buffered = ck_node.attribute_value("double_buffered", false);
+	} catch(...) { }
+
+	if(double_buffered && _copy_mode == COPY_ON_WRITE) {
+		Genode::warning("Double buffering is not supported in the copy-on-write mode");
+		return false;
+	}
+	return double_buffered;
+}
+
+
+bool Pd_session::_read_zero_pages()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("zero_pages", false);
+	} catch(...) { }
+	return false;
+}
+
+
+unsigned Pd_session::_read_copy_workers()
+{
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		return ck_node.attribute_value("copy_workers", 0U);
+	} catch(...) { }
+	return 0;
+}
+
+
+Genode::size_t Pd_session::_read_chunk_size()
+{
+	Genode::size_t size = 1024*1024;
+	try {
+		Genode::Xml_node ck_node = _config.xml().sub_node("checkpoint");
+		size = ck_node.attribute_value("chunk_size", Genode::Number_of_bytes(size));
+	} catch(...) { }
+
+	/* chunks cover whole words of the page bitmaps, which are modified
+	 * by the workers concurrently */
+	enum { WORD_PAGES_LOG2 = sizeof(Genode::addr_t) == 8 ? 6 : 5 };
+	return Genode::align_addr(Genode::max(size, (Genode::size_t)Ram_dataspace::PAGE_SIZE),
+	                          12 + WORD_PAGES_LOG2);
 }
 
 
@@ -109,7 +309,10 @@ void Pd_session::_checkpoint_signal_contexts()
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
 	_destroyed_signal_contexts.dequeue_all([&] (Signal_context_info &sc) {
-			_signal_contexts.remove(&sc);
+			{
+				Genode::Lock::Guard guard(_signal_contexts_lock);
+				_signal_contexts.remove(&sc);
+			}
 			Genode::destroy(_md_alloc, &sc);
 		});
 
@@ -128,7 +331,10 @@ void Pd_session::_checkpoint_signal_sources()
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
 	_destroyed_signal_sources.dequeue_all([&] (Signal_source_info &ss) {
-			_signal_sources.remove(&ss);
+			{
+				Genode::Lock::Guard guard(_signal_sources_lock);
+				_signal_sources.remove(&ss);
+			}
 			Genode::destroy(_md_alloc, &ss);
 		});
 	
@@ -143,7 +349,10 @@ void Pd_session::_checkpoint_native_capabilities()
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
 	_destroyed_native_caps.dequeue_all([&] (Native_capability_info &nc) {
-			_native_caps.remove(&nc);
+			{
+				Genode::Lock::Guard guard(_native_caps_lock);
+				_native_caps.remove(&nc);
+			}
 			Genode::destroy(_md_alloc, &nc);
 		});
 
@@ -159,33 +368,448 @@ void Pd_session::_checkpoint_ram_dataspaces()
 	DEBUG_THIS_CALL PROFILE_THIS_CALL
 		i_upgrade_args = _upgrade_args;
 
-	/* step 1: remove all destroyed dataspaces */
+	/* a checkpoint bounded by a time budget is copied in slices */
+	if(_time_budget) {
+		_checkpoint_ram_slice();
+		return;
+	}
+
+	/* step 1 & 2 */
+	_begin_ram_checkpoint();
+
+	/* step 3: copy memory of hot ds to cold ds. Frequently changing
+	 * dataspaces are copied last. */
+	for(unsigned pass = 0; pass < 2; pass++) {
+		Ram_dataspace_info *dataspace = _cold_ram_dataspaces;
+		while(dataspace) {
+			Ram_dataspace *ds = static_cast<Ram_dataspace*>(dataspace);
+			if(_hot(ds) == (pass == 1)) {
+				ds->checkpoint();
+				_copy_dataspace(ds);
+			}
+			dataspace = dataspace->next();
+		}
+	}
+
+	/* step 4 */
+	_end_ram_checkpoint();
+}
+
+
+void Pd_session::_begin_ram_checkpoint()
+{
+	/* step 1: remove all destroyed dataspaces. In the double-buffered
+	 * mode, the last checkpoint may still be serialized, therefore they are
+	 * removed by flip_ram_dataspaces(). */
+	if(!_double_buffered)
+		_remove_destroyed_dataspaces();
+
+	/* step 2: allocate cold dataspace for recently added dataspaces */
+	_alloc_cold_dataspaces();
+
+	_hash_hits = 0;
+	_hash_misses = 0;
+}
+
+
+void Pd_session::_end_ram_checkpoint()
+{
+	/* update the change statistics and compress stable dataspaces */
+	_generation++;
+	_changed_pages = 0;
+	_total_pages = 0;
+	_copied_pages = _full_pages;
+	_full_pages = 0;
+	for(Ram_dataspace_info *dataspace = _cold_ram_dataspaces; dataspace; dataspace = dataspace->next()) {
+		Ram_dataspace *ds = static_cast<Ram_dataspace*>(dataspace);
+		if(ds->changes.pages)
+			ds->incompressible = false;
+
+		/* the content compressed after the last checkpoint is still valid */
+		if(ds->pending_compressed) {
+			if(ds->changes.pages)
+				_drop_compressed(ds);
+			else
+				_adopt_compressed(ds);
+		}
+
+		_changed_pages += ds->changes.pages;
+		_copied_pages += ds->changes.pages;
+		_total_pages += ds->num_pages();
+		ds->changes.update(_generation, ds->num_pages());
+	}
+
+	/* step 4: move pointer forward to update ck_ram_dataspaces */
+	if(_double_buffered)
+		_copied_ram_dataspaces = _cold_ram_dataspaces;
+	else
+		i_ram_dataspaces = _cold_ram_dataspaces;
+}
+
+
+void Pd_session::_checkpoint_ram_slice()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	unsigned long long const start = ram_checkpointable.elapsed_us();
+
+	/* the last slice completed the checkpoint, start a new one */
+	if(!_ram_cursor.active) {
+		_begin_ram_checkpoint();
+		_ram_cursor.ds = _cold_ram_dataspaces;
+		_ram_cursor.offset = 0;
+		_ram_cursor.hot = false;
+		_ram_cursor.active = true;
+	}
+
+	/* copy at least one chunk per slice to guarantee progress */
+	_ram_cursor.slice_bytes = 0;
+	while(_ram_cursor.ds) {
+		Ram_dataspace *ds = static_cast<Ram_dataspace*>(_ram_cursor.ds);
+
+		bool copy = _hot(ds) == _ram_cursor.hot;
+		if(copy && _ram_cursor.offset == 0) {
+			ds->checkpoint();
+			copy = _begin_copy(ds);
+		}
+
+		if(copy) {
+			Genode::size_t const size = Genode::min(_chunk_size, ds->i_size - _ram_cursor.offset);
+			_copy_range(ds, _ram_cursor.offset, size);
+			_ram_cursor.offset += size;
+			_ram_cursor.slice_bytes += size;
+		}
+
+		if(!copy || _ram_cursor.offset >= ds->i_size) {
+			if(copy && _copy_mode == HASH)
+				ds->fingerprints->valid = true;
+			_ram_cursor.ds = _ram_cursor.ds->next();
+			_ram_cursor.offset = 0;
+
+			/* copy the hot dataspaces after all others */
+			if(!_ram_cursor.ds && !_ram_cursor.hot && _hot_threshold) {
+				_ram_cursor.ds = _cold_ram_dataspaces;
+				_ram_cursor.hot = true;
+			}
+		}
+
+		if(ram_checkpointable.elapsed_us() - start >= _time_budget)
+			break;
+	}
+
+	/* the cursor wrapped, all dataspaces are copied */
+	if(!_ram_cursor.ds) {
+		_ram_cursor.active = false;
+		_end_ram_checkpoint();
+	}
+}
+
+
+void Pd_session::flip_ram_dataspaces()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	_remove_destroyed_dataspaces();
+
+	Ram_dataspace_info *dataspace = _copied_ram_dataspaces;
+	while(dataspace) {
+		static_cast<Ram_dataspace*>(dataspace)->flip();
+		dataspace = dataspace->next();
+	}
+
+	i_ram_dataspaces = _copied_ram_dataspaces;
+}
+
+
+void Pd_session::_remove_destroyed_dataspaces()
+{
 	_destroyed_ram_dataspaces.dequeue_all([&] (Ram_dataspace_info &ds) {
-		_ram_dataspaces.remove(&ds);
+		/* keep the markers within the list */
+		if(&ds == _cold_ram_dataspaces)
+			_cold_ram_dataspaces = ds.next();
+		if(&ds == _copied_ram_dataspaces)
+			_copied_ram_dataspaces = ds.next();
+		if(&ds == i_ram_dataspaces)
+			i_ram_dataspaces = ds.next();
+		if(&ds == _ram_cursor.ds) {
+			_ram_cursor.ds = ds.next();
+			_ram_cursor.offset = 0;
+		}
+		{
+			Genode::Lock::Guard guard(_ram_dataspaces_lock);
+			_ram_dataspaces.remove(&ds);
+		}
 		_destroy_dataspace(static_cast<Ram_dataspace*>(&ds));
 		});
+}
 
-	/* step 2: allocate cold dataspace for recently added dataspaces */
+
+void Pd_session::_alloc_cold_dataspaces()
+{
 	Ram_dataspace_info *dataspace = _ram_dataspaces.first();
-	while(dataspace && dataspace != i_ram_dataspaces) {
-		_alloc_dataspace(static_cast<Ram_dataspace*>(dataspace));
-		_attach_dataspace(static_cast<Ram_dataspace*>(dataspace));
+	while(dataspace && dataspace != _cold_ram_dataspaces) {
+		Ram_dataspace *ds = static_cast<Ram_dataspace*>(dataspace);
+		if(!ds->cold_allocated) {
+			_alloc_dataspace(ds);
+			_attach_dataspace(ds);
+			ds->dst_cap = ds->i_dst_cap;
+			ds->cold_allocated = true;
+		}
+		if(_double_buffered && !ds->front)
+			_alloc_front_dataspace(ds);
 		dataspace = dataspace->next();
 	}
+	_cold_ram_dataspaces = _ram_dataspaces.first();
+}
+
+
+void Pd_session::_compress_stable_dataspaces()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	while(Retired_dataspace *retired = _retired_dataspaces.first()) {
+		_retired_dataspaces.remove(retired);
+		_env.rm().detach(retired->addr);
+		_env.ram().free(retired->cap);
+		Genode::destroy(_md_alloc, retired);
+	}
+
+	/* a checkpoint bounded by a time budget is not complete yet */
+	if(!_compress_after || _ram_cursor.active)
+		return;
+
+	/* the cold dataspaces are not modified until the next checkpoint */
+	for(Ram_dataspace_info *dataspace = i_ram_dataspaces; dataspace; dataspace = dataspace->next()) {
+		Ram_dataspace *ds = static_cast<Ram_dataspace*>(dataspace);
+		if(ds->dst && !ds->incompressible && !ds->pending_compressed
+		 && _generation - ds->changes.last_changed >= _compress_after)
+			_compress_dataspace(ds);
+	}
+}
+
+
+void Pd_session::_compress_dataspace(Ram_dataspace *ds)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+	Tracer::Scope trace("compress");
+
+	Genode::size_t const capacity = Lz4::bound(ds->i_size);
+	void *buffer = _md_alloc.alloc(capacity);
+	Genode::size_t const size = Lz4::compress(ds->dst, ds->i_size, buffer, capacity, *_lz4_table);
+
+	/* keep the cold dataspace, if less than a quarter is saved */
+	if(!size || size > ds->i_size - ds->i_size/4) {
+		_md_alloc.free(buffer, capacity);
+		ds->incompressible = true;
+		return;
+	}
+
+	void *compressed = _md_alloc.alloc(size);
+	Genode::memcpy(compressed, buffer, size);
+	_md_alloc.free(buffer, capacity);
+
+	ds->pending_compressed = compressed;
+	ds->pending_compressed_size = size;
+}
+
+
+void Pd_session::_adopt_compressed(Ram_dataspace *ds)
+{
+	/* freeing the cold dataspace is deferred until after the checkpoint */
+	if(!(_cold_pool.constructed() && _cold_pool->put(*ds)))
+		_retired_dataspaces.insert(new (_md_alloc) Retired_dataspace(ds->dst_cap, ds->dst));
+	ds->dst = nullptr;
+	ds->dst_cap = Genode::Ram_dataspace_capability();
+	ds->cold_size = 0;
+
+	ds->i_dst_cap = Genode::Ram_dataspace_capability();
+	ds->i_compressed = ds->pending_compressed;
+	ds->i_compressed_size = ds->pending_compressed_size;
+	ds->pending_compressed = nullptr;
+	ds->pending_compressed_size = 0;
+}
+
+
+void Pd_session::_drop_compressed(Ram_dataspace *ds)
+{
+	_md_alloc.free(ds->pending_compressed, ds->pending_compressed_size);
+	ds->pending_compressed = nullptr;
+	ds->pending_compressed_size = 0;
+}
+
+
+void Pd_session::_inflate_dataspace(Ram_dataspace *ds)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	/* a cold dataspace of the pool is already allocated and attached, so
+	 * that only the decompression remains within the checkpoint */
+	_alloc_dataspace(ds);
+	if(!ds->dst) ds->dst = _env.rm().attach(ds->i_dst_cap);
+	ds->dst_cap = ds->i_dst_cap;
+
+	if(Lz4::decompress(ds->i_compressed, ds->i_compressed_size, ds->dst, ds->i_size) != ds->i_size)
+		Genode::error("Decompression of a cold dataspace failed");
+
+	_md_alloc.free(const_cast<void*>(ds->i_compressed), ds->i_compressed_size);
+	ds->i_compressed = nullptr;
+	ds->i_compressed_size = 0;
+}
+
+
+void Pd_session::_release_cold_dataspace(Ram_dataspace *ds)
+{
+	if(!(_cold_pool.constructed() && _cold_pool->put(*ds))) {
+		_env.rm().detach(ds->dst);
+		_env.ram().free(ds->dst_cap);
+	}
+	ds->dst = nullptr;
+	ds->dst_cap = Genode::Ram_dataspace_capability();
+	ds->cold_size = 0;
+}
+
+
+void Pd_session::_alloc_front_dataspace(Ram_dataspace *ds)
+{
+	ds->front_cap = _env.ram().alloc(ds->i_size);
+	ds->front = _env.rm().attach(ds->front_cap);
+	ds->front_size = Genode::align_addr(ds->i_size, 12);
+
+	if(ds->zero_pages.constructed())
+		ds->front_zero_pages.construct(_md_alloc, ds->num_pages());
+
+	if(_copy_mode == HASH) {
+		if(!ds->fingerprints.constructed())
+			ds->fingerprints.construct(_md_alloc, ds->num_pages());
+		ds->front_fingerprints.construct(_md_alloc, ds->num_pages());
+	}
+
+	if(_copy_mode == INCREMENTAL) {
+		ds->missed_pages.construct(_md_alloc, ds->num_pages());
+		ds->copied_pages.construct(_md_alloc, ds->num_pages());
+	}
+}
+
 
-	/* step 3: copy memory of hot ds to cold ds */
-	dataspace = _ram_dataspaces.first();
+void Pd_session::snapshot_ram_dataspaces()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	i_upgrade_args = _upgrade_args;
+
+	_remove_destroyed_dataspaces();
+	_alloc_cold_dataspaces();
+
+	_generation++;
+	_changed_pages = 0;
+	_total_pages = 0;
+	_copied_pages = 0;
+	Ram_dataspace_info *dataspace = _ram_dataspaces.first();
 	while(dataspace) {
-		static_cast<Ram_dataspace*>(dataspace)->checkpoint();
-		_copy_dataspace(static_cast<Ram_dataspace*>(dataspace));
+		Ram_dataspace *ds = static_cast<Ram_dataspace*>(dataspace);
+		_write_tracker->protect(*ds);
+		ds->changes.pages += ds->copy_pages->count();
+		_changed_pages += ds->changes.pages;
+		_copied_pages += ds->changes.pages;
+		_total_pages += ds->num_pages();
+		ds->changes.update(_generation, ds->num_pages());
 		dataspace = dataspace->next();
 	}
 
-	/* step 4: move pointer forward to update ck_ram_dataspaces */
 	i_ram_dataspaces = _ram_dataspaces.first();
 }
 
 
+void Pd_session::_copy_snapshot()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	/* dataspaces allocated after the snapshot are not part of it */
+	Ram_dataspace_info *dataspace = i_ram_dataspaces;
+	while(dataspace) {
+		_write_tracker->copy(*static_cast<Ram_dataspace*>(dataspace));
+		dataspace = dataspace->next();
+	}
+}
+
+
+Genode::size_t Pd_session::zero_pages()
+{
+	Genode::size_t pages = 0;
+	Genode::Lock::Guard guard(_ram_dataspaces_lock);
+	for(Ram_dataspace_info *ds = _ram_dataspaces.first(); ds; ds = ds->next())
+		if(ds->i_zero_pages) pages += ds->i_zero_pages->count();
+	return pages;
+}
+
+
+Genode::size_t Pd_session::immutable_dataspaces()
+{
+	Genode::size_t count = 0;
+	Genode::Lock::Guard guard(_ram_dataspaces_lock);
+	for(Ram_dataspace_info *ds = _ram_dataspaces.first(); ds; ds = ds->next())
+		if(static_cast<Ram_dataspace*>(ds)->mutability == Ram_dataspace::IMMUTABLE)
+			count++;
+	return count;
+}
+
+
+Genode::size_t Pd_session::compressed_dataspaces()
+{
+	Genode::size_t count = 0;
+	Genode::Lock::Guard guard(_ram_dataspaces_lock);
+	for(Ram_dataspace_info *ds = _ram_dataspaces.first(); ds; ds = ds->next())
+		if(ds->i_compressed) count++;
+	return count;
+}
+
+
+Genode::size_t Pd_session::compressed_bytes()
+{
+	Genode::size_t bytes = 0;
+	Genode::Lock::Guard guard(_ram_dataspaces_lock);
+	for(Ram_dataspace_info *ds = _ram_dataspaces.first(); ds; ds = ds->next())
+		bytes += ds->i_compressed_size;
+	return bytes;
+}
+
+
+Genode::size_t Pd_session::hot_dataspaces()
+{
+	Genode::size_t count = 0;
+	Genode::Lock::Guard guard(_ram_dataspaces_lock);
+	for(Ram_dataspace_info *ds = _ram_dataspaces.first(); ds; ds = ds->next())
+		if(_hot(static_cast<Ram_dataspace*>(ds)))
+			count++;
+	return count;
+}
+
+
+Genode::size_t Pd_session::precopy_ram_dataspaces()
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	/* pre-copying would reset the pages pending for a sliced checkpoint */
+	if(!_write_tracker.constructed() || _time_budget)
+		return 0;
+
+	_alloc_cold_dataspaces();
+
+	/* hot dataspaces are left for the checkpoint of the paused child */
+	Genode::size_t pages = 0;
+	Ram_dataspace_info *dataspace = _ram_dataspaces.first();
+	while(dataspace) {
+		Ram_dataspace *ds = static_cast<Ram_dataspace*>(dataspace);
+		if(!_hot(ds)) {
+			_copy_dataspace(ds);
+			pages += ds->copy_pages->count();
+		}
+		dataspace = dataspace->next();
+	}
+	return pages;
+}
+
+
 void Pd_session::Pd_checkpointable::checkpoint()
 {
 	_pd->i_upgrade_args = _pd->_upgrade_args;
@@ -202,41 +826,228 @@ void Pd_session::Pd_checkpointable::checkpoint()
 
 void Pd_session::Ram_checkpointable::checkpoint()
 {
-	_pd->_checkpoint_ram_dataspaces();	
+	if(_pd->snapshot_mode())
+		_pd->_copy_snapshot();
+	else
+		_pd->_checkpoint_ram_dataspaces();
+}
+
+
+void Pd_session::Ram_checkpointable::post_checkpoint()
+{
+	_pd->_compress_stable_dataspaces();
+}
+
+
+void Pd_session::Copy_worker::checkpoint()
+{
+	_pd->_copy_chunks();
 }
 
 
 void Pd_session::_destroy_dataspace(Ram_dataspace *ds)
 {
-	/* detach */
-	_env.rm().detach(ds->dst);
-	_env.rm().detach(ds->src);
+	if(_write_tracker.constructed())
+		_write_tracker->untrack(*ds);
 
-	/* free */
+	if(ds->cold_allocated) _env.rm().detach(ds->src);
 	_parent_pd.free(ds->i_src_cap);
-	_env.ram().free(ds->i_dst_cap);
+
+	/* reuse the cold dataspace if possible */
+	if(ds->cold_allocated && ds->dst)
+		_release_cold_dataspace(ds);
+
+	if(ds->i_compressed)
+		_md_alloc.free(const_cast<void*>(ds->i_compressed), ds->i_compressed_size);
+	if(ds->pending_compressed)
+		_drop_compressed(ds);
+
+	if(ds->front) {
+		_env.rm().detach(ds->front);
+		_env.ram().free(ds->front_cap);
+	}
 
 	/* Destroy Ram_dataspace */
 	Genode::destroy(_md_alloc, ds);
 }
 
 
+bool Pd_session::_begin_copy(Ram_dataspace *ds)
+{
+	/* the cold dataspaces already hold the content of immutable dataspaces */
+	if(ds->mutability == Ram_dataspace::IMMUTABLE) {
+		if(ds->immutable_copies >= (ds->front ? 2u : 1u))
+			return false;
+		ds->immutable_copies++;
+	}
+
+	/* copy only the pages written since the last checkpoint */
+	if(_copy_mode == INCREMENTAL || _copy_mode == COPY_ON_WRITE) {
+		_write_tracker->protect(*ds);
+		ds->changes.pages += ds->copy_pages->count();
+	}
+
+	/* changed pages are copied into the decompressed cold dataspace */
+	if(ds->i_compressed) {
+		if(!ds->copy_pages->count())
+			return false;
+		_inflate_dataspace(ds);
+	}
+
+	/* bring pages up to date, which were only copied into the front */
+	if(ds->missed_pages.constructed()) {
+		ds->copied_pages->merge(*ds->copy_pages);
+		ds->copy_pages->merge(*ds->missed_pages);
+		ds->missed_pages->clear_all();
+	}
+
+	if(_copy_mode == HASH && !ds->fingerprints.constructed())
+		ds->fingerprints.construct(_md_alloc, ds->num_pages());
+
+	if(_copy_mode == FULL)
+		_full_pages += ds->num_pages();
+
+	return true;
+}
+
+
 void Pd_session::_copy_dataspace(Ram_dataspace *ds)
 {
 	DEBUG_THIS_CALL PROFILE_THIS_CALL;
 
-	Genode::memcpy(ds->dst, ds->src, ds->i_size);
+	if(!_begin_copy(ds))
+		return;
+
+	/* pages may be copied by the fault handler concurrently */
+	if(_copy_mode == COPY_ON_WRITE) {
+		_write_tracker->copy(*ds);
+		return;
+	}
+
+	if(!_copy_workers.first() || ds->i_size <= _chunk_size) {
+		_copy_range(ds, 0, ds->i_size);
+	} else {
+		/* copy chunks of large dataspaces by this thread and all workers */
+		{
+			Genode::Lock::Guard guard(_copy_lock);
+			_chunk_ds = ds;
+			_chunk_offset = 0;
+		}
+
+		for(Copy_worker *worker = _copy_workers.first(); worker; worker = worker->next())
+			worker->start_checkpoint();
+
+		_copy_chunks();
+
+		for(Copy_worker *worker = _copy_workers.first(); worker; worker = worker->next())
+			worker->join_checkpoint();
+	}
+
+	if(_copy_mode == HASH)
+		ds->fingerprints->valid = true;
+}
+
+
+void Pd_session::_copy_chunks()
+{
+	while(true) {
+		Ram_dataspace *ds;
+		Genode::size_t offset;
+		{
+			Genode::Lock::Guard guard(_copy_lock);
+			ds = _chunk_ds;
+			if(!ds || _chunk_offset >= ds->i_size)
+				return;
+			offset = _chunk_offset;
+			_chunk_offset += _chunk_size;
+		}
+
+		_copy_range(ds, offset, Genode::min(_chunk_size, ds->i_size - offset));
+	}
+}
+
+
+void Pd_session::_copy_range(Ram_dataspace *ds, Genode::size_t offset, Genode::size_t size)
+{
+	switch(_copy_mode) {
+	case FULL:
+		ds->copy(offset, size);
+		break;
+
+	case INCREMENTAL:
+	case COPY_ON_WRITE:
+		ds->copy_pages->for_each_run(offset / Ram_dataspace::PAGE_SIZE,
+		                             (size + Ram_dataspace::PAGE_SIZE - 1) / Ram_dataspace::PAGE_SIZE,
+		                             [&] (Genode::size_t first, Genode::size_t count) {
+			Genode::size_t const run_offset = first*Ram_dataspace::PAGE_SIZE;
+			Genode::size_t const run_size = Genode::min(count*Ram_dataspace::PAGE_SIZE,
+			                                            ds->i_size - run_offset);
+			ds->copy(run_offset, run_size);
+		});
+		break;
+
+	case HASH:
+		_copy_changed_pages(ds, offset, size);
+		break;
+	}
+}
+
+
+void Pd_session::_copy_changed_pages(Ram_dataspace *ds, Genode::size_t offset, Genode::size_t size)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	Fingerprint_table &fingerprints = *ds->fingerprints;
+	Genode::size_t hits = 0;
+	Genode::size_t misses = 0;
+
+	for(Genode::size_t page_offset = offset; page_offset < offset + size;
+	    page_offset += Ram_dataspace::PAGE_SIZE) {
+		Genode::size_t const page = page_offset / Ram_dataspace::PAGE_SIZE;
+		Genode::size_t const page_size = Genode::min((Genode::size_t)Ram_dataspace::PAGE_SIZE,
+		                                             ds->i_size - page_offset);
+		char *src = (char*)ds->src + page_offset;
+
+		/* the cold page is not modified while the hot page is zero */
+		if(ds->zero_pages.constructed()) {
+			bool const zero = is_zero(src, page_size);
+			if(zero) ds->zero_pages->set(page);
+			else     ds->zero_pages->clear(page);
+			if(zero) continue;
+		}
+
+		/* the first checkpoint of a dataspace copies all pages */
+		Genode::uint64_t const hash = page_hash(src, page_size);
+		if(fingerprints.valid && fingerprints[page] == hash) {
+			hits++;
+			continue;
+		}
+
+		copy_memory((char*)ds->dst + page_offset, src, page_size);
+		fingerprints[page] = hash;
+		misses++;
+	}
+
+	Genode::Lock::Guard guard(_copy_lock);
+	_hash_hits += hits;
+	_hash_misses += misses;
+	ds->changes.pages += misses;
 }
 
 
 void Pd_session::_alloc_dataspace(Ram_dataspace *ds)
 {
+	/* a cold dataspace of the pool is already attached */
+	if(_cold_pool.constructed() && _cold_pool->take(*ds))
+		return;
+
 	ds->i_dst_cap = _env.ram().alloc(ds->i_size);
+	ds->cold_size = Genode::align_addr(ds->i_size, 12);
 }
 
 void Pd_session::_attach_dataspace(Ram_dataspace *ds)
 {
-	ds->dst = _env.rm().attach(ds->i_dst_cap);
+	if(!ds->dst) ds->dst = _env.rm().attach(ds->i_dst_cap);
 	ds->src = _env.rm().attach(ds->i_src_cap);
 }
 
@@ -278,8 +1089,7 @@ void Pd_session::free_signal_source(Genode::Capability<Genode::Signal_source> ca
 	DEBUG_THIS_CALL;
 	/* Find list element */
 	Genode::Lock::Guard guard(_signal_sources_lock);
-	Signal_source_info *ss = _signal_sources.first();
-	if(ss) ss = ss->find_by_badge(cap.local_name());
+	Signal_source_info *ss = _signal_sources.find_by_badge(cap.local_name());
 	if(ss) {
 		/* Free signal source */
 		_parent_pd.free_signal_source(cap);
@@ -312,8 +1122,7 @@ void Pd_session::free_context(Genode::Signal_context_capability cap)
 {
 	/* Find list element */
 	Genode::Lock::Guard guard(_signal_contexts_lock);
-	Signal_context_info *sc = _signal_contexts.first();
-	if(sc) sc = sc->find_by_badge(cap.local_name());
+	Signal_context_info *sc = _signal_contexts.find_by_badge(cap.local_name());
 	if(sc) {
 		/* Free signal context */
 		_parent_pd.free_context(cap);
@@ -348,8 +1157,7 @@ void Pd_session::free_rpc_cap(Genode::Native_capability cap)
 {
 	/* Find list element */
 	Genode::Lock::Guard guard(_native_caps_lock);
-	Native_capability_info *nc = _native_caps.first();
-	if(nc) nc = nc->find_by_native_badge(cap.local_name());
+	Native_capability_info *nc = _native_caps.find_by_badge(cap.local_name());
 	if(nc) {
 		/* Free native capability */
 		_parent_pd.free_rpc_cap(cap);
@@ -447,6 +1255,24 @@ Genode::Ram_dataspace_capability Pd_session::alloc(Genode::size_t size,
 	                                                  size,
 	                                                  cached,
 	                                                  _child_info->bootstrapped);
+
+	/* a new dataspace is copied completely by the next checkpoint */
+	if(_write_tracker.constructed()) {
+		ds->dirty_pages.construct(_md_alloc, ds->num_pages(), true);
+		ds->copy_pages.construct(_md_alloc, ds->num_pages());
+	}
+
+	if(_zero_pages) {
+		ds->zero_pages.construct(_md_alloc, ds->num_pages());
+		ds->i_zero_pages = &*ds->zero_pages;
+	}
+
+	/* pair with a pre-allocated cold dataspace to save RPCs at checkpoint */
+	if(_cold_pool.constructed() && _cold_pool->take(*ds)) {
+		ds->src = _env.rm().attach(src_cap);
+		ds->cold_allocated = true;
+	}
+
 	Genode::Lock::Guard guard(_ram_dataspaces_lock);
 	_ram_dataspaces.insert(ds);
 
@@ -458,8 +1284,11 @@ void Pd_session::free(Genode::Ram_dataspace_capability ds_cap)
 {
 	DEBUG_THIS_CALL;	
 	/* Find the Ram_dataspace which monitors the given Ram_dataspace */
-	Ram_dataspace_info *rds = _ram_dataspaces.first();
-	if(rds) rds = rds->find_by_badge(ds_cap.local_name());
+	Ram_dataspace_info *rds = nullptr;
+	{
+		Genode::Lock::Guard guard(_ram_dataspaces_lock);
+		rds = _ram_dataspaces.find_by_badge(ds_cap.local_name());
+	}
 	if(rds) {
 		Genode::Lock::Guard lock_guard(_destroyed_ram_dataspaces_lock);
 		_destroyed_ram_dataspaces.enqueue(*rds);
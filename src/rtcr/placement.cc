@@ -0,0 +1,77 @@
+/*
+ * \brief  Automatic placement of checkpoint threads
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#include <rtcr/placement.h>
+#include <base/log.h>
+#include <util/string.h>
+
+using namespace Rtcr;
+
+
+Placement::Placement(Genode::Env &env)
+	:
+	_config(env, "config"),
+	_width(Genode::max(env.cpu().affinity_space().width(), 1U)),
+	_height(Genode::max(env.cpu().affinity_space().height(), 1U)),
+	_cores(Genode::min(_width*_height, (unsigned)MAX_CORES))
+{
+	for(unsigned core = 0; core < MAX_CORES; core++) {
+		_child_core[core] = false;
+		_load[core] = 0;
+	}
+
+	/* childs without affinity run on the first core */
+	_config.xml().for_each_sub_node("child", [&] (Genode::Xml_node child_node) {
+		unsigned const xpos = child_node.attribute_value("xpos", 0U);
+		unsigned const ypos = child_node.attribute_value("ypos", 0U);
+		unsigned const core = ypos*_width + xpos;
+		if(core < _cores) _child_core[core] = true;
+	});
+
+#ifdef VERBOSE
+	Genode::log("Placement on ", _width, "x", _height, " cores");
+#endif
+}
+
+
+unsigned long long Placement::_cost(char const *name) const
+{
+	unsigned long long cost = 1;
+	try {
+		_config.xml().sub_node("placement").for_each_sub_node("stage", [&] (Genode::Xml_node stage) {
+			Genode::String<32> const stage_name = stage.attribute_value("name", Genode::String<32>());
+			if(stage_name.length() > 1
+			 && !Genode::strcmp(stage_name.string(), name, stage_name.length() - 1))
+				cost = stage.attribute_value("cost", 1ULL);
+		});
+	} catch(...) { }
+	return cost;
+}
+
+
+Genode::Affinity::Location Placement::place(char const *name)
+{
+	Genode::Lock::Guard guard(_lock);
+
+	bool free_core = false;
+	for(unsigned core = 0; core < _cores; core++)
+		free_core |= !_child_core[core];
+
+	unsigned best = 0;
+	bool found = false;
+	for(unsigned core = 0; core < _cores; core++) {
+		if(free_core && _child_core[core])
+			continue;
+		if(!found || _load[core] < _load[best]) {
+			best = core;
+			found = true;
+		}
+	}
+
+	_load[best] += _cost(name);
+
+	return Genode::Affinity::Location(best % _width, best / _width, 1, 1);
+}
@@ -74,10 +74,10 @@ void Region_map::checkpoint()
 
 Attached_region *Region_map::find_attached_region_by_addr(Genode::addr_t addr)
 {
-	/* no lock needed, as we are looking for something, which will not be
-	 * deleted */
-	Attached_region_info *ar_info = _attached_regions.first();
-	ar_info = ar_info->find_by_addr(addr);
+	/* the tree is rebalanced by concurrent attachments */
+	Genode::Lock::Guard lock_guard(_attached_regions_lock);
+	Attached_region_info *ar_info = _attached_region_tree.first();
+	if(ar_info) ar_info = ar_info->find_in_tree(addr);
 	return static_cast<Attached_region*>(ar_info);
 }
 
@@ -115,15 +115,6 @@ Genode::Region_map::Local_addr Region_map::attach(Genode::Dataspace_capability d
 		}
 #endif
 
-	/* Attach dataspace to real Region map */
-	Genode::addr_t addr = _parent_region_map.attach(ds_cap,
-	                                                size,
-	                                                offset,
-	                                                use_local_addr,
-	                                                local_addr,
-	                                                executable,
-		writeable);
-
 	/* Actual size of the attached region; page-aligned */
 	Genode::size_t actual_size;
 	if(size == 0) {
@@ -134,6 +125,37 @@ Genode::Region_map::Local_addr Region_map::attach(Genode::Dataspace_capability d
 	}
 	//Genode::log("  actual_size=", Genode::Hex(actual_size));
 
+	/* Writes to a tracked Ram dataspace are observed through a managed
+	 * dataspace, which is attached instead */
+	Genode::Dataspace_capability managed_ds_cap;
+	if(_write_tracker && writeable)
+		managed_ds_cap = _write_tracker->track(ds_cap, actual_size, offset, executable);
+
+	/* Attach dataspace to real Region map */
+	Genode::addr_t addr;
+	try {
+		if(managed_ds_cap.valid()) {
+			addr = _parent_region_map.attach(managed_ds_cap,
+			                                 actual_size,
+			                                 0,
+			                                 use_local_addr,
+			                                 local_addr,
+			                                 executable,
+			                                 writeable);
+		} else {
+			addr = _parent_region_map.attach(ds_cap,
+			                                 size,
+			                                 offset,
+			                                 use_local_addr,
+			                                 local_addr,
+			                                 executable,
+			                                 writeable);
+		}
+	} catch (...) {
+		if(managed_ds_cap.valid()) _write_tracker->untrack(managed_ds_cap);
+		throw;
+	}
+
 	/* Store information about the attachment */
 	Attached_region *new_obj = new (_md_alloc) Attached_region(ds_cap,
 	                                                           actual_size,
@@ -141,6 +163,9 @@ Genode::Region_map::Local_addr Region_map::attach(Genode::Dataspace_capability d
 	                                                           addr,
 	                                                           executable,
 	                                                           _bootstrap_phase);
+	new_obj->managed_ds_cap = managed_ds_cap;
+
+	if(_classifier) _classifier->attached(ds_cap, writeable);
 
 #ifdef DEBUG
 	Genode::size_t num_pages = actual_size/4096;
@@ -154,6 +179,7 @@ Genode::Region_map::Local_addr Region_map::attach(Genode::Dataspace_capability d
 	/* Store Attached_region in a list */
 	Genode::Lock::Guard lock_guard(_attached_regions_lock);
 	_attached_regions.insert(new_obj);
+	_attached_region_tree.insert(new_obj);
 
 	return addr;
 }
@@ -165,11 +191,21 @@ void Region_map::detach(Region_map::Local_addr local_addr)
 	/* Detach from real region map */
 	_parent_region_map.detach(local_addr);
 
-	/* Find region */
-
-	Attached_region_info *region = _attached_regions.first();
-	if(region) region = region->find_by_addr((Genode::addr_t)local_addr);
+	/* Find region and remove it from the attached ones */
+	Attached_region_info *region = nullptr;
+	{
+		Genode::Lock::Guard lock_guard(_attached_regions_lock);
+		region = _attached_region_tree.first();
+		if(region) region = region->find_in_tree((Genode::addr_t)local_addr);
+		if(region) _attached_region_tree.remove(region);
+	}
 	if(region) {
+		/* stop tracking the writes to this region */
+		Genode::Dataspace_capability managed_ds_cap =
+			static_cast<Attached_region*>(region)->managed_ds_cap;
+		if(_write_tracker && managed_ds_cap.valid())
+			_write_tracker->untrack(managed_ds_cap);
+
 		/* Remove and destroy region from list and allocator */
 		Genode::Lock::Guard lock_guard(_destroyed_attached_regions_lock);
 		_destroyed_attached_regions.enqueue(*region);
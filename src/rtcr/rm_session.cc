@@ -7,6 +7,7 @@
 
 #include <rtcr/rm/rm_session.h>
 #include <rtcr/child_info.h>
+#include <rtcr/pd/pd_session.h>
 
 #ifdef PROFILE
 #include <util/profiler.h>
@@ -34,6 +35,7 @@ Rm_session::Rm_session(Genode::Env &env,
 	:
 	Checkpointable(env, "rm_session"),
 	Rm_session_info(creation_args, cap().local_name()),
+	_region_maps      (md_alloc),
 	_md_alloc         (md_alloc),
 	_env (env),
 	_ep               (ep),
@@ -70,6 +72,13 @@ Region_map &Rm_session::_create(Genode::size_t size)
 	                                                        _child_info->bootstrapped,
 	                                                        _ep);
 
+	/* Ram dataspaces may be attached to the custom Region map, too */
+	if(_child_info->pd_session) {
+		Pd_session *pd_session = static_cast<Pd_session*>(_child_info->pd_session);
+		new_region_map->classifier(pd_session->dataspace_classifier());
+		new_region_map->write_tracker(pd_session->write_tracker());
+	}
+
 	/* Insert custom Region map into list */
 	Genode::Lock::Guard lock(_region_maps_lock);
 	_region_maps.insert(new_region_map);
@@ -95,7 +104,10 @@ void Rm_session::checkpoint()
 		i_upgrade_args = _upgrade_args;
 
 	_destroyed_region_maps.dequeue_all([&] (Region_map_info &region_map) {
-			_region_maps.remove(&region_map);
+			{
+				Genode::Lock::Guard guard(_region_maps_lock);
+				_region_maps.remove(&region_map);
+			}
 			Genode::destroy(_md_alloc, &region_map);
 		});
 	
@@ -122,8 +134,11 @@ Genode::Capability<Genode::Region_map> Rm_session::create(Genode::size_t size)
 void Rm_session::destroy(Genode::Capability<Genode::Region_map> region_map_cap)
 {
 	/* Find RPC object for the given Capability */
-	Region_map_info *region_map = _region_maps.first();
-	if(region_map) region_map = region_map->find_by_badge(region_map_cap.local_name());
+	Region_map_info *region_map = nullptr;
+	{
+		Genode::Lock::Guard lock(_region_maps_lock);
+		region_map = _region_maps.find_by_badge(region_map_cap.local_name());
+	}
 	if(region_map) {
 		Genode::error("Issuing Rm_session::destroy, which is bugged and hangs up.");
 
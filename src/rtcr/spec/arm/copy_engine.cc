@@ -0,0 +1,40 @@
+/*
+ * \brief  Bulk copy of checkpointed memory for ARMv7
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+/* Genode includes */
+#include <util/string.h>
+
+/* Rtcr includes */
+#include <util/copy_engine.h>
+
+
+void Rtcr::copy_memory(void *dst, void const *src, Genode::size_t size)
+{
+	enum { BLOCK_SIZE = 64 };
+
+	char *d = (char*)dst;
+	char const *s = (char const*)src;
+
+	/*
+	 * ARMv7 provides no non-temporal stores. Instead, whole cache lines are
+	 * written with NEON stores, which lets Cortex-A cores switch into their
+	 * write-streaming mode without allocating the lines in L1. The source is
+	 * prefetched 256 bytes ahead.
+	 */
+	for(Genode::size_t n = size / BLOCK_SIZE; n; n--) {
+		asm volatile("pld    [%[s], #256]     \n"
+		             "vld1.8 {d0-d3}, [%[s]]! \n"
+		             "vld1.8 {d4-d7}, [%[s]]! \n"
+		             "vst1.8 {d0-d3}, [%[d]]! \n"
+		             "vst1.8 {d4-d7}, [%[d]]! \n"
+		             : [s] "+r" (s), [d] "+r" (d)
+		             :
+		             : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "memory");
+	}
+
+	if(size % BLOCK_SIZE)
+		Genode::memcpy(d, s, size % BLOCK_SIZE);
+}
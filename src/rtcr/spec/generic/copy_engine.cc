@@ -0,0 +1,18 @@
+/*
+ * \brief  Bulk copy of checkpointed memory for architectures without a
+ *         specific implementation
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+/* Genode includes */
+#include <util/string.h>
+
+/* Rtcr includes */
+#include <util/copy_engine.h>
+
+
+void Rtcr::copy_memory(void *dst, void const *src, Genode::size_t size)
+{
+	Genode::memcpy(dst, src, size);
+}
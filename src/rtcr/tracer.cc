@@ -0,0 +1,109 @@
+/*
+ * \brief  Timeline of the checkpoint phases
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#include <rtcr/tracer.h>
+#include <base/snprintf.h>
+
+using namespace Rtcr;
+
+
+Tracer *&Tracer::_current()
+{
+	static Tracer *tracer = nullptr;
+	return tracer;
+}
+
+
+Tracer::Tracer(Genode::Env &env, Genode::Allocator &alloc, Genode::size_t entries)
+	:
+	_alloc(alloc),
+	_timer(env),
+	/* a serialized event takes less than 160 characters */
+	_reporter(env, "rtcr_trace", "rtcr_trace", (entries + MAX_THREADS)*160 + 64),
+	_capacity(entries ? entries : 1),
+	_events((Event*)alloc.alloc(_capacity*sizeof(Event)))
+{
+	_reporter.enabled(true);
+	_current() = this;
+}
+
+
+Tracer::~Tracer()
+{
+	_current() = nullptr;
+	_alloc.free(_events, _capacity*sizeof(Event));
+}
+
+
+unsigned Tracer::_tid(Genode::Thread const *thread)
+{
+	for(unsigned i = 0; i < _num_threads; i++)
+		if(_threads[i] == thread) return i;
+
+	/* events of further threads are attributed to the last one */
+	if(_num_threads == MAX_THREADS)
+		return MAX_THREADS - 1;
+
+	_threads[_num_threads] = thread;
+	return _num_threads++;
+}
+
+
+void Tracer::_record(char const *name, bool begin)
+{
+	Genode::Thread const *thread = Genode::Thread::myself();
+	unsigned long long const time = _timer.elapsed_us();
+
+	Genode::Lock::Guard guard(_lock);
+
+	Event &event = _events[_next];
+	Genode::strncpy(event.name, name, sizeof(event.name));
+	event.time = time;
+	event.tid = _tid(thread);
+	event.core = thread ? thread->affinity().xpos() : 0;
+	event.begin = begin;
+
+	_next = (_next + 1) % _capacity;
+	if(_count < _capacity) _count++;
+}
+
+
+void Tracer::dump()
+{
+	Genode::Lock::Guard guard(_lock);
+
+	Genode::size_t const size = (_count + MAX_THREADS)*160 + 64;
+	char *json = (char*)_alloc.alloc(size);
+	Genode::size_t len = 0;
+
+	auto append = [&] (char const *format, auto... args) {
+		len += Genode::snprintf(json + len, size - len, format, args...);
+	};
+
+	append("{\"traceEvents\":[");
+
+	/* name the threads */
+	for(unsigned i = 0; i < _num_threads; i++) {
+		Genode::String<32> const name(_threads[i] ? _threads[i]->name() : "main");
+		append("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+		       "\"args\":{\"name\":\"%s\"}}", i ? "," : "", i, name.string());
+	}
+
+	/* oldest event first */
+	Genode::size_t const first = (_next + _capacity - _count) % _capacity;
+	for(Genode::size_t i = 0; i < _count; i++) {
+		Event const &event = _events[(first + i) % _capacity];
+		append("%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%llu,\"pid\":0,\"tid\":%u,"
+		       "\"args\":{\"core\":%ld}}",
+		       (i || _num_threads) ? "," : "", event.name, event.begin ? "B" : "E",
+		       event.time, event.tid, event.core);
+	}
+
+	append("]}");
+
+	_reporter.report(json, len);
+	_alloc.free(json, size);
+}
@@ -0,0 +1,231 @@
+/*
+ * \brief  Tracking of written pages of Ram dataspaces
+ * \author Johannes Fischer
+ * \date   2026-10-16
+ */
+
+#include <rtcr/rm/write_tracker.h>
+
+#ifdef PROFILE
+#include <util/profiler.h>
+#define PROFILE_THIS_CALL PROFILE_FUNCTION("plum");
+#else
+#define PROFILE_THIS_CALL
+#endif
+
+#if DEBUG
+#define DEBUG_THIS_CALL Genode::log("\e[38;5;176m", __PRETTY_FUNCTION__, "\033[0m");
+#else
+#define DEBUG_THIS_CALL
+#endif
+
+using namespace Rtcr;
+
+
+Write_tracker::Tracked_region::Tracked_region(Write_tracker &tracker,
+                                              Ram_dataspace &ds,
+                                              Genode::off_t offset,
+                                              Genode::size_t size,
+                                              bool executable)
+	:
+	_tracker(tracker),
+	ds(ds),
+	offset(offset),
+	size(size),
+	executable(executable),
+	rm_cap(tracker._rm.create(size)),
+	rm(rm_cap),
+	managed_ds_cap(rm.dataspace()),
+	attached(tracker._alloc, (size + tracker._granule_size() - 1) / tracker._granule_size()),
+	writeable(tracker._alloc, (size + tracker._granule_size() - 1) / tracker._granule_size()),
+	_fault_handler(tracker._ep, *this, &Tracked_region::_handle_fault)
+{
+	rm.fault_handler(_fault_handler);
+}
+
+
+void Write_tracker::Tracked_region::_handle_fault()
+{
+	DEBUG_THIS_CALL;
+
+	Genode::Region_map::State state = rm.state();
+	if(state.type == Genode::Region_map::State::READY)
+		return;
+
+	Genode::Lock::Guard guard(_tracker._lock);
+
+	Genode::size_t const granule_size = _tracker._granule_size();
+	Genode::size_t const granule = state.addr / granule_size;
+	Genode::addr_t const start = granule*granule_size;
+	if(start >= size) {
+		Genode::error("Fault at ", Genode::Hex(state.addr), " outside of tracked region");
+		return;
+	}
+	Genode::size_t const length = Genode::min(granule_size, size - start);
+
+	Genode::size_t const first_page = (offset + start) / Ram_dataspace::PAGE_SIZE;
+	Genode::size_t const pages = length / Ram_dataspace::PAGE_SIZE;
+
+	/* a read fault attaches the granule read-only, so its pages stay clean */
+	if(state.type != Genode::Region_map::State::WRITE_FAULT) {
+		if(attached.get(granule))
+			return;
+
+		/* attaching resolves the fault and resumes the faulting thread */
+		rm.attach(ds.i_src_cap, length, offset + start, true, start, executable, false);
+		attached.set(granule);
+		return;
+	}
+
+	if(writeable.get(granule))
+		return;
+
+	/* the whole granule becomes writeable, so all of its pages are dirty */
+	ds.dirty_pages->set(first_page, pages);
+
+	/* preserve the checkpointed content before the child modifies it */
+	if(_tracker._copy_on_write)
+		_tracker._copy_pages(ds, first_page, pages);
+
+	if(attached.get(granule))
+		rm.detach(start);
+	rm.attach(ds.i_src_cap, length, offset + start, true, start, executable, true);
+	attached.set(granule);
+	writeable.set(granule);
+}
+
+
+void Write_tracker::Tracked_region::protect()
+{
+	Genode::size_t const granule_size = _tracker._granule_size();
+	writeable.for_each_run([&] (Genode::size_t first, Genode::size_t count) {
+		for(Genode::size_t granule = first; granule < first + count; granule++)
+			rm.detach(granule*granule_size);
+		attached.clear(first, count);
+	});
+	writeable.clear_all();
+}
+
+
+Write_tracker::Write_tracker(Genode::Env &env,
+                             Genode::Allocator &alloc,
+                             Genode::Entrypoint &ep,
+                             Genode::Lock &ram_dataspaces_lock,
+                             Badge_list<Ram_dataspace_info> &ram_dataspaces,
+                             Genode::size_t granularity,
+                             bool copy_on_write)
+	:
+	_env(env),
+	_alloc(alloc),
+	_ep(ep),
+	_rm(env),
+	_granularity(granularity ? granularity : 1),
+	_ram_dataspaces_lock(ram_dataspaces_lock),
+	_ram_dataspaces(ram_dataspaces),
+	_copy_on_write(copy_on_write)
+{
+	DEBUG_THIS_CALL;
+}
+
+
+Write_tracker::~Write_tracker()
+{
+	Genode::Lock::Guard guard(_lock);
+	while(Tracked_region *region = _regions.first())
+		_destroy(region);
+}
+
+
+void Write_tracker::_destroy(Tracked_region *region)
+{
+	_regions.remove(region);
+	region->protect();
+
+	/* Rm_session::destroy hangs, therefore the managed dataspace is not
+	 * destroyed */
+	Genode::destroy(_alloc, region);
+}
+
+
+Genode::Dataspace_capability Write_tracker::track(Genode::Dataspace_capability ds_cap,
+                                                  Genode::size_t size,
+                                                  Genode::off_t offset,
+                                                  bool executable)
+{
+	DEBUG_THIS_CALL;
+
+	Ram_dataspace *ds = nullptr;
+	{
+		Genode::Lock::Guard guard(_ram_dataspaces_lock);
+		Ram_dataspace_info *info = _ram_dataspaces.find_by_badge(ds_cap.local_name());
+		ds = static_cast<Ram_dataspace*>(info);
+	}
+
+	if(!ds || !ds->dirty_pages.constructed())
+		return Genode::Dataspace_capability();
+
+	Tracked_region *region = new (_alloc) Tracked_region(*this, *ds, offset, size, executable);
+
+	Genode::Lock::Guard guard(_lock);
+	_regions.insert(region);
+	return region->managed_ds_cap;
+}
+
+
+void Write_tracker::untrack(Genode::Dataspace_capability managed_ds_cap)
+{
+	Genode::Lock::Guard guard(_lock);
+	Tracked_region *region = _regions.first();
+	while(region && region->managed_ds_cap.local_name() != managed_ds_cap.local_name())
+		region = region->next();
+
+	if(region) _destroy(region);
+}
+
+
+void Write_tracker::untrack(Ram_dataspace &ds)
+{
+	Genode::Lock::Guard guard(_lock);
+	Tracked_region *region = _regions.first();
+	while(region) {
+		Tracked_region *next = region->next();
+		if(&region->ds == &ds) _destroy(region);
+		region = next;
+	}
+}
+
+
+void Write_tracker::protect(Ram_dataspace &ds)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	Genode::Lock::Guard guard(_lock);
+	for(Tracked_region *region = _regions.first(); region; region = region->next())
+		if(&region->ds == &ds) region->protect();
+
+	ds.copy_pages->take(*ds.dirty_pages);
+}
+
+
+void Write_tracker::_copy_pages(Ram_dataspace &ds, Genode::size_t first, Genode::size_t count)
+{
+	ds.copy_pages->for_each_run(first, count, [&] (Genode::size_t run, Genode::size_t n) {
+		Genode::size_t const offset = run*Ram_dataspace::PAGE_SIZE;
+		Genode::size_t const size = Genode::min(n*Ram_dataspace::PAGE_SIZE,
+		                                        ds.i_size - offset);
+		ds.copy(offset, size);
+	});
+	ds.copy_pages->clear(first, count);
+}
+
+
+void Write_tracker::copy(Ram_dataspace &ds)
+{
+	DEBUG_THIS_CALL PROFILE_THIS_CALL;
+
+	enum { CHUNK_PAGES = 16 };
+	for(Genode::size_t first = 0; first < ds.num_pages(); first += CHUNK_PAGES) {
+		Genode::Lock::Guard guard(_lock);
+		_copy_pages(ds, first, CHUNK_PAGES);
+	}
+}
@@ -7,6 +7,7 @@
 #include <rtcr_serializer/serializer.h>
 #include "zlib.h"
 #include <base/fixed_stdint.h>
+#include <util/lz4.h>
 
 #ifdef PROFILE
 #include <util/profiler.h>
@@ -80,7 +81,7 @@ void Serializer::attach(Genode::Region_map_client &rm, Genode::List<Attachment>
 	Attachment *a = as.first();
 	Genode::addr_t offset = 0;
 	while(a) {
-		a->addr = rm.attach_at(a->cap, offset);
+		a->addr = rm.attach_at(a->cap, offset, a->size, a->ds_offset);
 		if(a->pb) a->pb->set_offset(offset);
 #ifdef DEBUG
 		Genode::log("Region Map attach",
@@ -102,6 +103,32 @@ void Serializer::detach(Genode::Region_map_client &rm, Genode::List<Attachment>
 	}
 }
 
+Genode::Dataspace_capability Serializer::cold_dataspace(Ram_dataspace_info *info)
+{
+	if(!info->i_compressed)
+		return info->i_dst_cap;
+
+	Genode::Ram_dataspace_capability cap = _env.ram().alloc(page_aligned_size(info->i_size));
+	void *dst = _env.rm().attach(cap);
+	if(Lz4::decompress(info->i_compressed, info->i_compressed_size, dst, info->i_size) != info->i_size)
+		Genode::error("Decompression of a cold dataspace failed");
+	_env.rm().detach(dst);
+
+	_inflated.insert(new(_alloc) Inflated_dataspace(cap));
+	return cap;
+}
+
+
+void Serializer::free_inflated()
+{
+	while(Inflated_dataspace *ds = _inflated.first()) {
+		_inflated.remove(ds);
+		_env.ram().free(ds->cap);
+		Genode::destroy(_alloc, ds);
+	}
+}
+
+
 void Serializer::free(Genode::List<Attachment> &as)
 {
 	while(Attachment *a = as.first()) {
@@ -153,11 +180,15 @@ Genode::Ram_dataspace_capability Serializer::serialize(
 	} catch (...) {
 		detach(region_map, attachments);
 		free(attachments);
+		free_inflated();
 		_env.ram().free(pb_ds_cap);
 		// 	_rm_connection.destroy(region_map);  /* hangs... */		
 
 		throw Genode::Exception();
 	}
+
+	/* the decompressed cold dataspaces are part of the compressed output */
+	free_inflated();
 #ifdef VERBOSE
 	Genode::log(" rate=",100-(int) (((float)*compressed_size/total_size)*100),"%",
 	            " compressed_size=", Genode::Hex(*compressed_size),
@@ -479,12 +510,45 @@ void Serializer::add_ram_dataspace(Capability_mapping *_cm,
 	info->set_cached(_info->i_cached);
 	info->set_timestamp(_info->i_timestamp);
 
-	Pb::Attachment *attachment = new(_alloc) Pb::Attachment();
-	attachment->set_offset(0);
-	info->set_allocated_attachment(attachment);
-	as.insert(new(_alloc) Attachment(_info->i_dst_cap,
-	                                 page_aligned_size(_info->i_size),
-	                                 attachment));
+	Genode::Dataspace_capability const cold_cap = cold_dataspace(_info);
+
+	if(!_info->i_zero_pages) {
+		Pb::Attachment *attachment = new(_alloc) Pb::Attachment();
+		attachment->set_offset(0);
+		info->set_allocated_attachment(attachment);
+		as.insert(new(_alloc) Attachment(cold_cap,
+		                                 page_aligned_size(_info->i_size),
+		                                 attachment));
+		return;
+	}
+
+	/* store only runs of pages which are not zero */
+	info->set_sparse(true);
+	Bitmap const &zero_pages = *_info->i_zero_pages;
+	Genode::size_t const pages = page_aligned_size(_info->i_size) / _PAGE_SIZE;
+	Genode::size_t page = 0;
+	while(page < pages) {
+		if(zero_pages.get(page)) {
+			page++;
+			continue;
+		}
+
+		Genode::size_t const first = page;
+		while(page < pages && !zero_pages.get(page))
+			page++;
+
+		Pb::Page_run *run = info->add_page_run();
+		run->set_first(first);
+		run->set_count(page - first);
+
+		Pb::Attachment *attachment = new(_alloc) Pb::Attachment();
+		attachment->set_offset(0);
+		run->set_allocated_attachment(attachment);
+		as.insert(new(_alloc) Attachment(cold_cap,
+		                                 (page - first)*_PAGE_SIZE,
+		                                 first*_PAGE_SIZE,
+		                                 attachment));
+	}
 }
 
 
@@ -780,8 +844,22 @@ Ram_dataspace_info *Serializer::parse_ram_dataspace(const Pb::Ram_dataspace_info
 	/* parse attachemnt */
 	Genode::Ram_dataspace_capability src_cap = _env.ram().alloc(info.size());
 	void *dst = _env.rm().attach(src_cap);
-	void *src = raw_addr + info.attachment().offset();
-	Genode::memcpy(dst, src, info.size());
+	if(info.sparse()) {
+		/* pages which are not stored are zero, like the pages of a new
+		 * dataspace */
+		for(int i = 0; i < info.page_run_size(); i++) {
+			const Pb::Page_run &run = info.page_run(i);
+			Genode::size_t const offset = run.first()*_PAGE_SIZE;
+			Genode::size_t const size = Genode::min(run.count()*_PAGE_SIZE,
+			                                        (Genode::size_t)info.size() - offset);
+			Genode::memcpy((char*)dst + offset,
+			               (char*)raw_addr + run.attachment().offset(),
+			               size);
+		}
+	} else {
+		void *src = raw_addr + info.attachment().offset();
+		Genode::memcpy(dst, src, info.size());
+	}
 
 	_info->i_src_cap = src_cap;
 	return _info;